@@ -0,0 +1,41 @@
+#include "BatchInput.h"
+#include "Util/SVFUtil.h"
+#include <iostream>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+BatchInput::BatchInput(const std::string &fileName)
+{
+    if (fileName.empty()) {
+        in = &cin;
+    } else {
+        file.open(fileName);
+        in = &file;
+    }
+}
+
+bool BatchInput::isOpen() const
+{
+    return in == &cin || file.is_open();
+}
+
+std::list<std::string> BatchInput::readLine()
+{
+    string line;
+    while (getline(*in, line)) {
+        boost::algorithm::trim(line);
+        if (line.size() == 0 || line[0] == '#') {
+            continue;
+        }
+        SVFUtil::outs() << "> " << line << "\n";
+        std::list<std::string> args;
+        boost::split(args, line, boost::is_any_of(" "), boost::token_compress_on);
+        return args;
+    }
+    return {"exit"};
+}
@@ -0,0 +1,26 @@
+#ifndef BATCHINPUT_H
+#define BATCHINPUT_H
+
+#include "Input.h"
+#include <fstream>
+#include <istream>
+#include <string>
+#include <list>
+
+
+/// Reads commands from a script or a pipe without readline. Empty lines and
+/// lines starting with # are skipped, every command is echoed to the output.
+class BatchInput : public Input
+{
+private:
+    std::ifstream file;
+    std::istream *in;
+
+public:
+    /// read from file, or from stdin if file is empty
+    BatchInput(const std::string &fileName);
+    bool isOpen() const;
+    std::list<std::string> readLine();
+};
+
+#endif // BATCHINPUT_H
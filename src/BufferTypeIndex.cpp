@@ -0,0 +1,90 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BufferTypeIndex.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+
+using namespace llvm;
+using namespace std;
+
+/// element type addressed by a GEP, the field type for struct members
+static Type *getGEPType(const GetElementPtrInst *gep)
+{
+    Type *type = gep->getSourceElementType();
+    if (auto st = dyn_cast<StructType>(type)) {
+        if (gep->getNumOperands() > 2) {
+            if (auto nr = dyn_cast<ConstantInt>(gep->getOperand(2))) {
+                return st->getElementType(nr->getZExtValue());
+            }
+        }
+    }
+    return type;
+}
+
+Type *BufferTypeIndex::getBufferType(const Value *value)
+{
+    auto inst = dyn_cast<Instruction>(value);
+    if (inst == NULL) {
+        return value->getType();
+    }
+    const Function *func = inst->getFunction();
+    shared_lock<shared_mutex> shared(lock);
+    if (functions.count(func) == 0) {
+        shared.unlock();
+        {
+            unique_lock<shared_mutex> exclusive(lock);
+            if (functions.insert(func).second) {
+                index(func);
+            }
+        }
+        shared.lock();
+    }
+    auto it = types.find(value);
+    if (it == types.end()) {
+        return value->getType();
+    }
+    return it->second;
+}
+
+/// A GEP points into the buffer of its source element type. A pointer
+/// loaded from a GEP, e.g. a buffer pointer stored in a struct field,
+/// points into the buffer the GEP addresses. All other values, including
+/// casts and extensions, have no known buffer beyond their own type.
+void BufferTypeIndex::index(const Function *func)
+{
+    for (const Instruction &inst : instructions(func)) {
+        if (auto gep = dyn_cast<GetElementPtrInst>(&inst)) {
+            types[gep] = getGEPType(gep);
+        } else if (auto load = dyn_cast<LoadInst>(&inst)) {
+            auto gep = dyn_cast<GetElementPtrInst>(load->getPointerOperand());
+            if (gep != NULL) {
+                types[load] = getGEPType(gep);
+            } else {
+                types[load] = load->getPointerOperand()->getType();
+            }
+        }
+    }
+}
+
+void BufferTypeIndex::clear()
+{
+    unique_lock<shared_mutex> guard(lock);
+    types.clear();
+    functions.clear();
+}
@@ -0,0 +1,53 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BUFFERTYPEINDEX_H
+#define BUFFERTYPEINDEX_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Type.h"
+#include "llvm/IR/Value.h"
+#include <mutex>
+#include <new>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+/// Maps pointer values to the type of the buffer they point into. Every
+/// function is indexed in one pass over its instructions the first time
+/// one of its values is looked up, the result is kept for all later runs.
+/// Thread-safe, lookups in indexed functions share the lock.
+class BufferTypeIndex
+{
+private:
+    std::unordered_map<const llvm::Value*, llvm::Type*> types;
+    std::unordered_set<const llvm::Function*> functions;
+    std::shared_mutex lock;
+
+    void index(const llvm::Function *func);
+
+public:
+    llvm::Type* getBufferType(const llvm::Value *value);
+    /// forget all functions, the modules are about to be released
+    void clear();
+    /// in a forked child, the lock may be held by a thread of the parent
+    void resetLock() {
+        new (&lock) std::shared_mutex;
+    }
+};
+
+#endif // BUFFERTYPEINDEX_H
@@ -0,0 +1,142 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BuildStats.h"
+#include "llvm/Support/Format.h"
+#include <fstream>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+using namespace llvm;
+using namespace std;
+
+BuildStats::Timer::Timer(BuildStats &stats, const string &name) : stats(stats), stopped(false)
+{
+    phase.name = name;
+    phase.rssDelta = getRSS();
+    wallStart = chrono::steady_clock::now();
+    cpuStart = getThreadCPUTime();
+    lock_guard<mutex> guard(stats.lock);
+    running = stats.running.insert(stats.running.end(), Running{name, wallStart});
+}
+
+BuildStats::Timer::~Timer()
+{
+    stop();
+}
+
+void BuildStats::Timer::stop(unsigned int nodes, unsigned int edges)
+{
+    if (stopped) {
+        return;
+    }
+    stopped = true;
+    {
+        lock_guard<mutex> guard(stats.lock);
+        stats.running.erase(running);
+    }
+    phase.wallTime = chrono::duration<double>(chrono::steady_clock::now() - wallStart).count();
+    phase.cpuTime = getThreadCPUTime() - cpuStart;
+    phase.rss = getRSS();
+    phase.rssDelta = phase.rss - phase.rssDelta;
+    phase.nodes = nodes;
+    phase.edges = edges;
+    stats.add(phase);
+}
+
+void BuildStats::add(const Phase &phase)
+{
+    lock_guard<mutex> guard(lock);
+    phases.push_back(phase);
+}
+
+vector<BuildStats::Phase> BuildStats::getRunning() const
+{
+    lock_guard<mutex> guard(lock);
+    auto now = chrono::steady_clock::now();
+    vector<Phase> phases;
+    for (auto &it : running) {
+        Phase phase = Phase();
+        phase.name = it.name;
+        phase.wallTime = chrono::duration<double>(now - it.wallStart).count();
+        phases.push_back(phase);
+    }
+    return phases;
+}
+
+vector<BuildStats::Phase> BuildStats::getPhases() const
+{
+    lock_guard<mutex> guard(lock);
+    return phases;
+}
+
+void BuildStats::print(raw_ostream &os) const
+{
+    os << "phase               wall[s]     cpu[s]    rss[MB]  delta[MB]        nodes        edges\n";
+    double wall = 0, cpu = 0;
+    for (auto &phase : getPhases()) {
+        os << format("%-16s %10.2f %10.2f %10.1f %10.1f %12u %12u\n", phase.name.c_str(),
+                     phase.wallTime, phase.cpuTime, phase.rss / 1024.0, phase.rssDelta / 1024.0,
+                     phase.nodes, phase.edges);
+        wall += phase.wallTime;
+        cpu += phase.cpuTime;
+    }
+    os << format("total            %10.2f %10.2f %10.1f\n", wall, cpu, getRSS() / 1024.0);
+    os << format("peak rss: %.1f MB\n", getPeakRSS() / 1024.0);
+}
+
+void BuildStats::printJSON(raw_ostream &os) const
+{
+    os << "{\"phases\": [";
+    bool first = true;
+    for (auto &phase : getPhases()) {
+        os << (first ? "" : ", ");
+        os << "{\"name\": \"" << phase.name << "\"";
+        os << format(", \"wall\": %.6f, \"cpu\": %.6f", phase.wallTime, phase.cpuTime);
+        os << ", \"rss_kb\": " << phase.rss << ", \"rss_delta_kb\": " << phase.rssDelta;
+        os << ", \"nodes\": " << phase.nodes << ", \"edges\": " << phase.edges << "}";
+        first = false;
+    }
+    os << "], \"rss_kb\": " << getRSS() << ", \"peak_rss_kb\": " << getPeakRSS() << "}\n";
+}
+
+long BuildStats::getRSS()
+{
+    ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+long BuildStats::getPeakRSS()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
+
+double BuildStats::getThreadCPUTime()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,92 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BUILDSTATS_H
+#define BUILDSTATS_H
+
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+/// Time, memory and size of every graph construction phase
+class BuildStats
+{
+public:
+    struct Phase {
+        std::string name;
+        double wallTime;    ///< seconds
+        double cpuTime;     ///< seconds of the building thread
+        long rss;           ///< resident set size after the phase in KB
+        long rssDelta;      ///< change of the resident set size in KB
+        unsigned int nodes;
+        unsigned int edges;
+    };
+
+    /// phase which is built at the moment
+    struct Running {
+        std::string name;
+        std::chrono::steady_clock::time_point wallStart;
+    };
+
+    /// Measures one phase from construction until stop() is called
+    class Timer
+    {
+    private:
+        BuildStats &stats;
+        Phase phase;
+        std::list<Running>::iterator running;
+        std::chrono::steady_clock::time_point wallStart;
+        double cpuStart;
+        bool stopped;
+
+    public:
+        Timer(BuildStats &stats, const std::string &name);
+        ~Timer();
+        void stop(unsigned int nodes = 0, unsigned int edges = 0);
+    };
+
+private:
+    std::vector<Phase> phases;
+    std::list<Running> running;
+    mutable std::mutex lock;
+
+public:
+    void add(const Phase &phase);
+    std::vector<Phase> getPhases() const;
+    /// the phases being built with their wall time so far, outer ones first
+    std::vector<Phase> getRunning() const;
+    /// in a forked child, the lock may be held by a thread of the parent
+    void resetLock() {
+        new (&lock) std::mutex;
+    }
+
+    void print(llvm::raw_ostream &os) const;
+    void printJSON(llvm::raw_ostream &os) const;
+
+    /// current resident set size in KB
+    static long getRSS();
+    /// peak resident set size in KB
+    static long getPeakRSS();
+    /// CPU time of the calling thread in seconds
+    static double getThreadCPUTime();
+};
+
+#endif // BUILDSTATS_H
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CallSiteIndex.h"
+#include "Util/SVFUtil.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+static bool byCallNodeId(const CallSiteEntry &a, const CallSiteEntry &b)
+{
+    return a.call->getId() < b.call->getId();
+}
+
+CallSiteIndex::CallSiteIndex(ICFG *icfg) : icfg(icfg), hasIndirect(false)
+{
+    for (ICFG::iterator i = icfg->begin(); i != icfg->end(); i++) {
+        ICFGNode *n = i->second;
+        if (n->getNodeKind() != ICFGNode::FunCallBlock) {
+            continue;
+        }
+        CallBlockNode *c = static_cast<CallBlockNode *>(n);
+        auto call = dyn_cast<CallBase>(c->getCallSite());
+        if (call == NULL) {
+            continue;
+        }
+        // look through bitcasts of the called function
+        auto func = dyn_cast<Function>(call->getCalledOperand()->stripPointerCasts());
+        if (func != NULL) {
+            add(string(func->getName()), c);
+        }
+    }
+}
+
+void CallSiteIndex::add(const string &callee, const CallBlockNode *call)
+{
+    CallSiteEntry entry;
+    entry.call = call;
+    entry.ret = icfg->getRetBlockNode(call->getCallSite());
+    callees[callee].push_back(entry);
+}
+
+void CallSiteIndex::addIndirectCalls(PTACallGraph *callgraph)
+{
+    if (hasIndirect) {
+        return;
+    }
+    hasIndirect = true;
+    set<string> changed;
+    for (auto &it : callgraph->getIndCallMap()) {
+        for (auto func : it.second) {
+            string name(func->getName());
+            add(name, it.first);
+            changed.insert(name);
+        }
+    }
+    // the indirect call map is unordered, keep the lists in ICFG order
+    for (auto &name : changed) {
+        CallSiteList &callSites = callees[name];
+        sort(callSites.begin(), callSites.end(), byCallNodeId);
+    }
+}
+
+const CallSiteList &CallSiteIndex::getCallSites(const string &callee) const
+{
+    auto it = callees.find(callee);
+    if (it == callees.end()) {
+        return empty;
+    }
+    return it->second;
+}
+
+void CallSiteIndex::getCallSitesByPrefix(const string &prefix, CallSiteList &callSites) const
+{
+    for (auto it = callees.lower_bound(prefix); it != callees.end(); it++) {
+        if (it->first.compare(0, prefix.size(), prefix) != 0) {
+            break;
+        }
+        callSites.insert(callSites.end(), it->second.begin(), it->second.end());
+    }
+    sort(callSites.begin(), callSites.end(), byCallNodeId);
+}
@@ -0,0 +1,53 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CALLSITEINDEX_H
+#define CALLSITEINDEX_H
+
+#include "Graphs/ICFG.h"
+#include "Graphs/PTACallGraph.h"
+#include "svf-plugin.h"
+#include <map>
+#include <string>
+
+/// Maps callee names to the call sites calling them. Direct calls are taken
+/// from the ICFG, indirect calls from the targets resolved in the call graph.
+class CallSiteIndex
+{
+private:
+    SVF::ICFG *icfg;
+    std::map<std::string, CallSiteList> callees;
+    bool hasIndirect;
+    CallSiteList empty;
+
+    void add(const std::string &callee, const SVF::CallBlockNode *call);
+
+public:
+    CallSiteIndex(SVF::ICFG *icfg);
+
+    /// add the indirect call targets of the call graph, only done once
+    void addIndirectCalls(SVF::PTACallGraph *callgraph);
+    bool hasIndirectCalls() const {
+        return hasIndirect;
+    }
+
+    const CallSiteList &getCallSites(const std::string &callee) const;
+    /// call sites of all callees starting with prefix, in call node ID order
+    void getCallSitesByPrefix(const std::string &prefix, CallSiteList &callSites) const;
+};
+
+#endif // CALLSITEINDEX_H
@@ -18,13 +18,18 @@ using namespace SVF;
 
 ConsoleInput::ConsoleInput()
 {
-    fs::path home("/home");
-    fs::path user(getenv("USER"));
     fs::path hist_file(".local/share/svf-server-history");
-    fs::path hist = home / user.filename() / hist_file;
-    history_file = hist;
+    const char *home = getenv("HOME");
+    const char *user = getenv("USER");
+    if (home != NULL) {
+        history_file = fs::path(home) / hist_file;
+    } else if (user != NULL) {
+        history_file = fs::path("/home") / fs::path(user).filename() / hist_file;
+    }
     history_max_entries = 100;
-    read_history(history_file.c_str());
+    if (!history_file.empty()) {
+        read_history(history_file.c_str());
+    }
 }
 
 std::list<std::string> ConsoleInput::readLine()
@@ -33,12 +38,18 @@ std::list<std::string> ConsoleInput::readLine()
     char *s;
     while (true) {
         s=readline("> ");
+        if (s == NULL) {
+            // end of input (Ctrl-D)
+            return {"exit"};
+        }
         line = s;
         boost::algorithm::trim(line);
         if (line.size() > 0 && line != prev_cmd) {
             add_history(s);
             stifle_history(history_max_entries);
-            write_history(history_file.c_str());
+            if (!history_file.empty()) {
+                write_history(history_file.c_str());
+            }
         }
         prev_cmd = line;
         free(s);
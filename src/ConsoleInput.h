@@ -1,11 +1,12 @@
 #ifndef CONSOLEINPUT_H
 #define CONSOLEINPUT_H
 
+#include "Input.h"
 #include <string>
 #include <list>
 
 
-class ConsoleInput
+class ConsoleInput : public Input
 {
 private:
     std::string prev_cmd;
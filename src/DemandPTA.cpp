@@ -0,0 +1,151 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DemandPTA.h"
+#include "SVFOptions.h"
+#include "Util/Options.h"
+#include <unordered_set>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+/// ContextDDA takes the budget of every query from SVF's process-wide
+/// -cxtbg, it has no budget per instance. The option is only changed for
+/// the duration of a query, the queries of all instances are serialized.
+static mutex budgetLock;
+/// -cxtbg as given on the command line
+static unsigned int cxtBudget = 0;
+
+DemandPTA::DemandPTA(SVFModule *svfModule, SVFIR *pag, unsigned int budget)
+    : pag(pag), queries(0), hits(0), outOfBudget(0)
+{
+    {
+        lock_guard<mutex> guard(budgetLock);
+        if (cxtBudget == 0) {
+            cxtBudget = Options::CxtBudget;
+        }
+    }
+    defaultBudget = budget;
+    if (defaultBudget == 0) {
+        defaultBudget = cxtBudget;
+    }
+    client = new DDAClient(svfModule);
+    dda = new ContextDDA(pag, client);
+    dda->initialize();
+}
+
+DemandPTA::~DemandPTA()
+{
+    delete dda;
+    delete client;
+}
+
+bool DemandPTA::getPointsTo(NodeID ptr, PointsTo &pts, unsigned int budget)
+{
+    if (budget == 0) {
+        budget = defaultBudget;
+    }
+    lock_guard<mutex> guard(lock);
+    queries++;
+    auto it = cache.find(ptr);
+    if (it != cache.end() && (it->second.complete || it->second.budget >= budget)) {
+        hits++;
+        pts = it->second.pts;
+        return it->second.complete;
+    }
+
+    Result &result = cache[ptr];
+    {
+        // the budget of a query is read from -cxtbg when it starts
+        lock_guard<mutex> options(budgetLock);
+        SVFOptions::set("cxtbg", to_string(budget));
+        dda->computeDDAPts(ptr);
+        result.complete = !dda->isOutOfBudgetQuery();
+        SVFOptions::set("cxtbg", to_string(cxtBudget));
+    }
+    result.pts = dda->getPts(ptr);
+    result.budget = budget;
+    if (!result.complete) {
+        outOfBudget++;
+    }
+    pts = result.pts;
+    return result.complete;
+}
+
+bool DemandPTA::mayFlow(NodeID from, NodeID to, unsigned int budget, bool &reached)
+{
+    if (budget == 0) {
+        budget = defaultBudget;
+    }
+    lock_guard<mutex> guard(lock);
+    queries++;
+    auto it = flows.find(make_pair(from, to));
+    if (it != flows.end() && (it->second.complete || it->second.budget >= budget)) {
+        hits++;
+        reached = it->second.reached;
+        return it->second.complete;
+    }
+
+    // forward along the def-use edges from the definition of from
+    SVFG *svfg = dda->getSVFG();
+    const PAGNode *src = pag->getGNode(from);
+    const PAGNode *dst = pag->getGNode(to);
+    Flow &flow = flows[make_pair(from, to)];
+    flow.reached = false;
+    flow.complete = true;
+    flow.budget = budget;
+    if (svfg->hasDefSVFGNode(src) && svfg->hasDefSVFGNode(dst)) {
+        const VFGNode *target = svfg->getDefSVFGNode(dst);
+        const VFGNode *start = svfg->getDefSVFGNode(src);
+        flow.reached = start == target;
+        unordered_set<NodeID> visited = {start->getId()};
+        vector<const VFGNode*> worklist = {start};
+        while (!worklist.empty() && !flow.reached) {
+            if (visited.size() > budget) {
+                flow.complete = false;
+                break;
+            }
+            const VFGNode *node = worklist.back();
+            worklist.pop_back();
+            for (const VFGEdge *edge : node->getOutEdges()) {
+                const VFGNode *next = edge->getDstNode();
+                if (next == target) {
+                    flow.reached = true;
+                    break;
+                }
+                if (visited.insert(next->getId()).second) {
+                    worklist.push_back(next);
+                }
+            }
+        }
+    }
+    if (!flow.complete) {
+        outOfBudget++;
+        flow.reached = true;
+    }
+    reached = flow.reached;
+    return flow.complete;
+}
+
+void DemandPTA::printStats(raw_ostream &os)
+{
+    lock_guard<mutex> guard(lock);
+    os << "demand queries: " << queries << " cached: " << hits << " out of budget: " << outOfBudget
+       << " pointers: " << cache.size() << " flows: " << flows.size() << " budget: " << defaultBudget << "\n";
+}
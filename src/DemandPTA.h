@@ -0,0 +1,84 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DEMANDPTA_H
+#define DEMANDPTA_H
+
+#include "DDA/ContextDDA.h"
+#include "DDA/DDAClient.h"
+#include "llvm/Support/raw_ostream.h"
+#include <map>
+#include <mutex>
+#include <new>
+#include <utility>
+
+/// Demand-driven, context-sensitive points-to queries (SVF's ContextDDA) and
+/// value-flow queries on its pointer-only SVFG.
+///
+/// Every query is solved on its own with a budget of traversal steps, a
+/// query which runs out of budget falls back to the result of the
+/// pre-analysis and is marked incomplete. Results are cached, an incomplete
+/// result is recomputed if it is queried again with a larger budget. SVF's
+/// solver is not reentrant and reads the budget from the process-wide
+/// -cxtbg, so the queries of all instances are serialized and the option
+/// is restored after each of them.
+class DemandPTA
+{
+private:
+    struct Result {
+        SVF::PointsTo pts;
+        bool complete;
+        unsigned int budget;
+    };
+    struct Flow {
+        bool reached;
+        bool complete;
+        unsigned int budget;
+    };
+
+    SVF::SVFIR *pag;
+    SVF::DDAClient *client;
+    SVF::ContextDDA *dda;
+    unsigned int defaultBudget;
+    std::map<SVF::NodeID, Result> cache;
+    std::map<std::pair<SVF::NodeID, SVF::NodeID>, Flow> flows;
+    unsigned int queries;
+    unsigned int hits;
+    unsigned int outOfBudget;
+    std::mutex lock;
+
+public:
+    /// budget 0 keeps SVF's default (-cxtbg)
+    DemandPTA(SVF::SVFModule *svfModule, SVF::SVFIR *pag, unsigned int budget);
+    ~DemandPTA();
+
+    /// points-to set of the pointer, returns false if the query ran out of
+    /// budget and pts is the conservative result of the pre-analysis
+    bool getPointsTo(SVF::NodeID ptr, SVF::PointsTo &pts, unsigned int budget);
+    /// whether the value of the pointer from may flow into the pointer to,
+    /// budget limits the visited SVFG nodes. Returns false if the search ran
+    /// out of budget, reached is then true
+    bool mayFlow(SVF::NodeID from, SVF::NodeID to, unsigned int budget, bool &reached);
+
+    void printStats(llvm::raw_ostream &os);
+    /// in a forked child, the lock may be held by a thread of the parent
+    void resetLock() {
+        new (&lock) std::mutex;
+    }
+};
+
+#endif // DEMANDPTA_H
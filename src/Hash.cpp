@@ -0,0 +1,82 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Hash.h"
+#include <sstream>
+#include <iomanip>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static const uint64_t fnvPrime = 1099511628211ULL;
+
+uint64_t Hash::update(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= fnvPrime;
+    }
+    return hash;
+}
+
+uint64_t Hash::hashString(const string &str, uint64_t hash)
+{
+    // include the terminator, so "ab","c" and "a","bc" differ
+    return update(hash, str.c_str(), str.size() + 1);
+}
+
+uint64_t Hash::hashFiles(const vector<string> &files)
+{
+    uint64_t hash = offset;
+    for (auto &file : files) {
+        hashFile(file, hash);
+    }
+    return hash;
+}
+
+bool Hash::hashFile(const string &file, uint64_t &hash)
+{
+    hash = hashString(file, hash);
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+    if (ok && st.st_size > 0) {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ok = data != MAP_FAILED;
+        if (ok) {
+            madvise(data, st.st_size, MADV_SEQUENTIAL);
+            hash = update(hash, data, st.st_size);
+            munmap(data, st.st_size);
+        }
+    }
+    close(fd);
+    return ok;
+}
+
+string Hash::toHex(uint64_t hash)
+{
+    stringstream ss;
+    ss << hex << setw(16) << setfill('0') << hash;
+    return ss.str();
+}
@@ -0,0 +1,42 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// FNV-1a content hashes used to identify inputs, plugins and results
+class Hash
+{
+public:
+    static const uint64_t offset = 14695981039346656037ULL;
+
+    static uint64_t update(uint64_t hash, const void *data, size_t size);
+    static uint64_t hashString(const std::string &str, uint64_t hash = offset);
+    /// hash over the names and the mmapped content of the given files,
+    /// files which cannot be read only contribute their name
+    static uint64_t hashFiles(const std::vector<std::string> &files);
+    /// add the name and content of file to hash, false if it cannot be read
+    static bool hashFile(const std::string &file, uint64_t &hash);
+    static std::string toHex(uint64_t hash);
+};
+
+#endif // HASH_H
@@ -0,0 +1,17 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <string>
+#include <list>
+
+
+/// Source of command lines for a session
+class Input
+{
+public:
+    virtual ~Input() {}
+    /// next command split into arguments, returns {"exit"} at end of input
+    virtual std::list<std::string> readLine() = 0;
+};
+
+#endif // INPUT_H
@@ -0,0 +1,171 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NODETABLE_H
+#define NODETABLE_H
+
+#include "Graphs/ICFG.h"
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Read-only table of the nodes of a graph, built once after construction.
+/// Every column is a flat array indexed by row. The rows are ordered by
+/// function and node ID, so the nodes of a function are one contiguous
+/// range; the rows of each node kind are listed separately in node ID order.
+/// Scans over a kind or a function stream through the arrays instead of
+/// chasing node and edge pointers through the graph.
+template<typename NodeTy>
+class NodeTable
+{
+public:
+    /// rows or kind rows [begin, end)
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+    };
+    static constexpr uint32_t npos = UINT32_MAX;
+
+private:
+    std::vector<const NodeTy*> nodes;
+    std::vector<SVF::NodeID> ids;
+    std::vector<uint8_t> kinds;
+    std::vector<uint32_t> inDegrees;
+    std::vector<uint32_t> outDegrees;
+    /// functions in order of their first node ID, NULL for global nodes
+    std::vector<const SVF::SVFFunction*> functions;
+    std::vector<Range> functionRanges;
+    std::vector<uint32_t> kindRows;
+    std::vector<Range> kindRanges;
+    /// row of every node ID
+    std::vector<uint32_t> rows;
+
+public:
+    /// the graph iterates its nodes in ID order
+    template<typename GraphTy>
+    explicit NodeTable(GraphTy *graph) {
+        std::vector<const NodeTy*> byId;
+        std::vector<uint32_t> functionOf;
+        std::unordered_map<const SVF::SVFFunction*, uint32_t> functionIndex;
+        byId.reserve(graph->getTotalNodeNum());
+        functionOf.reserve(graph->getTotalNodeNum());
+        SVF::NodeID maxId = 0;
+        size_t maxKind = 0;
+        for (auto it = graph->begin(); it != graph->end(); it++) {
+            const NodeTy *node = it->second;
+            auto inserted = functionIndex.insert(std::make_pair(node->getFun(), functions.size()));
+            if (inserted.second) {
+                functions.push_back(node->getFun());
+            }
+            byId.push_back(node);
+            functionOf.push_back(inserted.first->second);
+            maxId = std::max(maxId, node->getId());
+            maxKind = std::max(maxKind, static_cast<size_t>(node->getNodeKind()));
+        }
+
+        // counting sort by function, stable in ID order; the range ends
+        // serve as insert positions while the rows are filled
+        size_t size = byId.size();
+        functionRanges.assign(functions.size(), Range{0, 0});
+        for (uint32_t f : functionOf) {
+            functionRanges[f].end++;
+        }
+        uint32_t begin = 0;
+        for (auto &range : functionRanges) {
+            uint32_t count = range.end;
+            range.begin = begin;
+            range.end = begin;
+            begin += count;
+        }
+        nodes.resize(size);
+        ids.resize(size);
+        kinds.resize(size);
+        inDegrees.resize(size);
+        outDegrees.resize(size);
+        rows.assign(size > 0 ? maxId + 1 : 0, npos);
+        for (size_t i = 0; i < size; i++) {
+            const NodeTy *node = byId[i];
+            uint32_t row = functionRanges[functionOf[i]].end++;
+            nodes[row] = node;
+            ids[row] = node->getId();
+            kinds[row] = node->getNodeKind();
+            inDegrees[row] = node->getInEdges().size();
+            outDegrees[row] = node->getOutEdges().size();
+            rows[node->getId()] = row;
+        }
+
+        // same for the kinds
+        kindRanges.assign(size > 0 ? maxKind + 1 : 0, Range{0, 0});
+        for (const NodeTy *node : byId) {
+            kindRanges[node->getNodeKind()].end++;
+        }
+        begin = 0;
+        for (auto &range : kindRanges) {
+            uint32_t count = range.end;
+            range.begin = begin;
+            range.end = begin;
+            begin += count;
+        }
+        kindRows.resize(size);
+        for (const NodeTy *node : byId) {
+            kindRows[kindRanges[node->getNodeKind()].end++] = rows[node->getId()];
+        }
+    }
+
+    uint32_t size() const {
+        return nodes.size();
+    }
+    const NodeTy* getNode(uint32_t row) const {
+        return nodes[row];
+    }
+    SVF::NodeID getId(uint32_t row) const {
+        return ids[row];
+    }
+    unsigned int getKind(uint32_t row) const {
+        return kinds[row];
+    }
+    uint32_t getInDegree(uint32_t row) const {
+        return inDegrees[row];
+    }
+    uint32_t getOutDegree(uint32_t row) const {
+        return outDegrees[row];
+    }
+    /// row of the node with ID id, npos if there is none
+    uint32_t getRow(SVF::NodeID id) const {
+        return id < rows.size() ? rows[id] : npos;
+    }
+
+    const std::vector<const SVF::SVFFunction*>& getFunctions() const {
+        return functions;
+    }
+    /// rows of the nodes of getFunctions()[function]
+    Range getFunctionRange(size_t function) const {
+        return functionRanges[function];
+    }
+
+    /// positions of the rows of kind, pass them to getKindRow
+    Range getKindRange(unsigned int kind) const {
+        return kind < kindRanges.size() ? kindRanges[kind] : Range{0, 0};
+    }
+    uint32_t getKindRow(uint32_t i) const {
+        return kindRows[i];
+    }
+};
+
+#endif // NODETABLE_H
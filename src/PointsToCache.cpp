@@ -0,0 +1,143 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PointsToCache.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+FlatPointsTo::FlatPointsTo(const PointsTo &pts, const PointsTo &expandedPts, NodeID blackHole)
+    : unknown(pts.test(blackHole))
+{
+    fill(pts, objects);
+    if (expandedPts.count() != pts.count()) {
+        fill(expandedPts, expanded);
+    }
+}
+
+void FlatPointsTo::fill(const PointsTo &pts, Bits &bits)
+{
+    // the points-to set may iterate in the order of its node mapping
+    vector<NodeID> ids(pts.begin(), pts.end());
+    std::sort(ids.begin(), ids.end());
+    for (NodeID id : ids) {
+        uint32_t key = id / blockBits;
+        if (bits.keys.empty() || bits.keys.back() != key) {
+            bits.keys.push_back(key);
+            bits.blocks.push_back(Block());
+        }
+        bits.blocks.back()[id % blockBits / 64] |= uint64_t(1) << (id % 64);
+    }
+    bits.keys.shrink_to_fit();
+    bits.blocks.shrink_to_fit();
+}
+
+bool FlatPointsTo::intersects(const FlatPointsTo &other) const
+{
+    if (unknown || other.unknown) {
+        return true;
+    }
+    const Bits &x = getAliasBits();
+    const Bits &y = other.getAliasBits();
+    size_t i = 0, j = 0;
+    while (i < x.keys.size() && j < y.keys.size()) {
+        if (x.keys[i] < y.keys[j]) {
+            i++;
+        } else if (x.keys[i] > y.keys[j]) {
+            j++;
+        } else {
+            const Block &a = x.blocks[i];
+            const Block &b = y.blocks[j];
+            uint64_t common = 0;
+            for (size_t w = 0; w < a.size(); w++) {
+                common |= a[w] & b[w];
+            }
+            if (common != 0) {
+                return true;
+            }
+            i++;
+            j++;
+        }
+    }
+    return false;
+}
+
+void FlatPointsTo::getObjects(vector<NodeID> &objects) const
+{
+    for (size_t i = 0; i < this->objects.keys.size(); i++) {
+        const Block &block = this->objects.blocks[i];
+        for (size_t w = 0; w < block.size(); w++) {
+            for (uint64_t bits = block[w]; bits != 0; bits &= bits - 1) {
+                objects.push_back(this->objects.keys[i] * blockBits + w * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+}
+
+size_t FlatPointsTo::getSize() const
+{
+    size_t size = sizeof(*this);
+    for (const Bits *bits : {&objects, &expanded}) {
+        size += bits->keys.capacity() * sizeof(uint32_t) + bits->blocks.capacity() * sizeof(Block);
+    }
+    return size;
+}
+
+PointsToCache::PointsToCache(SVFIR *pag, PointerAnalysis *pta, size_t maxMemoryMB)
+    : pag(pag), pta(pta), memorySize(0), maxMemorySize(maxMemoryMB << 20), hits(0), misses(0)
+{
+}
+
+/// The lookup in SVF's points-to data may insert an empty set, so misses
+/// are resolved under the lock as well
+PointsToCache::Result PointsToCache::get(NodeID ptr)
+{
+    lock_guard<mutex> guard(lock);
+    auto it = entries.find(ptr);
+    if (it != entries.end()) {
+        hits++;
+        lru.splice(lru.begin(), lru, it->second.lru);
+        return it->second.pts;
+    }
+    misses++;
+    // SVF's alias query compares the sets with the fields of
+    // field-insensitive objects, which alias all of their fields
+    const PointsTo &objects = pta->getPts(ptr);
+    PointsTo expanded;
+    pta->expandFIObjs(objects, expanded);
+    Result pts(new FlatPointsTo(objects, expanded, pag->getBlackHoleNode()));
+    lru.push_front(ptr);
+    entries[ptr] = Entry{pts, lru.begin()};
+    memorySize += pts->getSize();
+    // the least recently used sets are dropped, runs may still hold them
+    while (memorySize > maxMemorySize && lru.size() > 1) {
+        auto last = entries.find(lru.back());
+        memorySize -= last->second.pts->getSize();
+        entries.erase(last);
+        lru.pop_back();
+    }
+    return pts;
+}
+
+void PointsToCache::printStats(raw_ostream &os)
+{
+    lock_guard<mutex> guard(lock);
+    os << "points-to sets in memory: " << entries.size() << " (" << (memorySize >> 10) << " KB of "
+       << (maxMemorySize >> 20) << " MB) queries: " << hits + misses << " cached: " << hits << "\n";
+}
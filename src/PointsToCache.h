@@ -0,0 +1,114 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef POINTSTOCACHE_H
+#define POINTSTOCACHE_H
+
+#include "MemoryModel/PointerAnalysis.h"
+#include "llvm/Support/raw_ostream.h"
+#include <array>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+/// Points-to set as a flat array of 256 bit blocks, sorted by block. Unlike
+/// SVF's linked sparse bit vectors, an intersection streams through
+/// contiguous memory and ANDs whole blocks without branching, which the
+/// compiler vectorizes.
+class FlatPointsTo
+{
+public:
+    typedef std::array<uint64_t, 4> Block;
+    static const unsigned int blockBits = 256;
+
+private:
+    struct Bits {
+        std::vector<uint32_t> keys;
+        std::vector<Block> blocks;
+    };
+    Bits objects;
+    /// the objects and all fields of the field-insensitive and base objects
+    /// among them, as SVF compares them for aliases; empty if the same
+    Bits expanded;
+    /// contains the black hole, may point to anything
+    bool unknown;
+
+    static void fill(const SVF::PointsTo &pts, Bits &bits);
+    const Bits& getAliasBits() const {
+        return expanded.keys.empty() ? objects : expanded;
+    }
+
+public:
+    /// expanded by PointerAnalysis::expandFIObjs
+    FlatPointsTo(const SVF::PointsTo &pts, const SVF::PointsTo &expanded, SVF::NodeID blackHole);
+
+    /// true if the expanded sets share an object or one of them is unknown,
+    /// the answer of SVF's alias query
+    bool intersects(const FlatPointsTo &other) const;
+    /// object node IDs in ascending order
+    void getObjects(std::vector<SVF::NodeID> &objects) const;
+    /// memory in bytes
+    size_t getSize() const;
+};
+
+/// Points-to sets of the whole-program pointer analysis for alias and
+/// points-to queries, converted to FlatPointsTo and kept in least recently
+/// used order up to a size limit. Thread-safe.
+class PointsToCache
+{
+public:
+    typedef std::shared_ptr<const FlatPointsTo> Result;
+
+private:
+    struct Entry {
+        Result pts;
+        std::list<SVF::NodeID>::iterator lru;
+    };
+
+    SVF::SVFIR *pag;
+    SVF::PointerAnalysis *pta;
+    std::unordered_map<SVF::NodeID, Entry> entries;
+    /// most recently used first
+    std::list<SVF::NodeID> lru;
+    size_t memorySize;
+    size_t maxMemorySize;
+    unsigned int hits;
+    unsigned int misses;
+    std::mutex lock;
+
+public:
+    /// size in MB
+    PointsToCache(SVF::SVFIR *pag, SVF::PointerAnalysis *pta, size_t maxMemoryMB);
+
+    /// points-to set of the pointer node ptr
+    Result get(SVF::NodeID ptr);
+    bool mayAlias(SVF::NodeID a, SVF::NodeID b) {
+        return get(a)->intersects(*get(b));
+    }
+
+    void printStats(llvm::raw_ostream &os);
+    /// in a forked child, the lock may be held by a thread of the parent
+    void resetLock() {
+        new (&lock) std::mutex;
+    }
+};
+
+#endif // POINTSTOCACHE_H
@@ -0,0 +1,1090 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Program.h"
+#include "SVF-FE/LLVMUtil.h"
+#include "Util/SVFUtil.h"
+#include "Util/Options.h"
+#include "ThreadPool.h"
+#include "ResultSink.h"
+#include "Hash.h"
+#include "SVFOptions.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include <algorithm>
+#include <malloc.h>
+#include <new>
+#include <unistd.h>
+#include <unordered_set>
+#include "WPA/Steensgaard.h"
+#include "WPA/AndersenSFR.h"
+#include "WPA/FlowSensitive.h"
+#include "WPA/FlowSensitiveTBHC.h"
+#include "WPA/VersionedFlowSensitive.h"
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+/// nodes per shard of a parallel traversal
+static const size_t shardSize = 4096;
+
+/// Visit the items [0, count) in shards on the thread pool and replay the
+/// buffered output of the shards in order
+static void parallelForShards(size_t count, const function<void(size_t, ResultSink&)> &visit,
+                              ResultSink &sink)
+{
+    size_t shards = (count + shardSize - 1) / shardSize;
+    vector<BufferedSink> output(shards);
+    ThreadPool::parallelFor(shards, [&](size_t shard) {
+        size_t end = min(count, (shard + 1) * shardSize);
+        for (size_t i = shard * shardSize; i < end; i++) {
+            visit(i, output[shard]);
+        }
+    });
+    for (auto &out : output) {
+        out.finish();
+        out.replay(sink);
+    }
+}
+
+template<typename NodeTy>
+static void parallelForNodes(const vector<const NodeTy*> &nodes,
+                             const function<void(const NodeTy*, ResultSink&)> &visitor,
+                             ResultSink &sink)
+{
+    parallelForShards(nodes.size(), [&](size_t i, ResultSink &shard) {
+        visitor(nodes[i], shard);
+    }, sink);
+}
+
+/// Visit nodes once for all checkers: the callbacks are looked up by node
+/// kind, output[shard][checker] buffers the output of each checker per shard.
+/// getNodes is only called if any checker registered for the graph.
+template<typename NodeTy, typename VisitorTy>
+static void fusedForNodes(const vector<CheckerVisitors> &checkers,
+                          const vector<pair<int, VisitorTy>>& (CheckerVisitors::*getVisitors)() const,
+                          const function<const vector<const NodeTy*>&()> &getNodes,
+                          vector<vector<BufferedSink>> &output)
+{
+    vector<vector<pair<size_t, const VisitorTy*>>> byKind;
+    for (size_t c = 0; c < checkers.size(); c++) {
+        for (auto &visitor : (checkers[c].*getVisitors)()) {
+            if (visitor.first < 0) {
+                continue;
+            }
+            if (byKind.size() <= static_cast<size_t>(visitor.first)) {
+                byKind.resize(visitor.first + 1);
+            }
+            byKind[visitor.first].push_back(make_pair(c, &visitor.second));
+        }
+    }
+    if (byKind.empty()) {
+        return;
+    }
+
+    const vector<const NodeTy*> &nodes = getNodes();
+    size_t shards = (nodes.size() + shardSize - 1) / shardSize;
+    output = vector<vector<BufferedSink>>(shards);
+    ThreadPool::parallelFor(shards, [&](size_t shard) {
+        output[shard] = vector<BufferedSink>(checkers.size());
+        size_t end = min(nodes.size(), (shard + 1) * shardSize);
+        for (size_t i = shard * shardSize; i < end; i++) {
+            size_t kind = nodes[i]->getNodeKind();
+            if (kind >= byKind.size()) {
+                continue;
+            }
+            for (auto &visitor : byKind[kind]) {
+                (*visitor.second)(nodes[i], output[shard][visitor.first]);
+            }
+        }
+    });
+}
+
+/// Pointer analyses of SVF which can be selected by name. Only Andersen's
+/// analysis is taken from its singleton, it is shared with the flow-sensitive
+/// and demand-driven analyses as pre-analysis, which resolve the same
+/// indirect calls. SFR and SCD crash, versioned
+/// flow-sensitive analysis is not supported.
+static PointerAnalysis* createPTA(const string &kind, SVFIR *pag)
+{
+    PointerAnalysis *pta = NULL;
+    if (kind == "andersen") {
+        return AndersenWaveDiff::createAndersenWaveDiff(pag);
+    } else if (kind == "steensgaard") {
+        pta = new Steensgaard(pag);
+    } else if (kind == "hcd") {
+        pta = new AndersenHCD(pag);
+    } else if (kind == "lcd") {
+        pta = new AndersenLCD(pag);
+    } else if (kind == "hlcd") {
+        pta = new AndersenHLCD(pag);
+    } else if (kind == "fs") {
+        pta = new FlowSensitive(pag);
+    } else if (kind == "fstbhc") {
+        pta = new FlowSensitiveTBHC(pag);
+    } else {
+        return NULL;
+    }
+    pta->analyze();
+    return pta;
+}
+
+const vector<string>& Program::getPTAKinds()
+{
+    static const vector<string> kinds = {"andersen", "steensgaard", "hcd", "lcd", "hlcd", "fs", "fstbhc"};
+    return kinds;
+}
+
+bool Program::isPTAKind(const string &kind)
+{
+    auto &kinds = getPTAKinds();
+    return find(kinds.begin(), kinds.end(), kind) != kinds.end();
+}
+
+Program::Program(const vector<string> &moduleNameVec, Snapshot *snapshot,
+                 ResultCache *resultCache, const string &ptaKind)
+    : moduleNameVec(moduleNameVec), snapshot(snapshot), resultCache(resultCache),
+      svfModule(NULL), pag(NULL), pta(NULL), vfg(NULL), svfg(NULL), svfBuilder(NULL), ptaKind(ptaKind),
+      andersenBuilt(false), demandPTA(NULL), demandBudget(0), queryCacheMemory(64), callSiteIndex(NULL),
+      svfgTable(NULL), ptsCache(NULL), icfgTable(NULL), valueIndex(NULL), published(0), generation(0), workerPool(NULL), resident(false), lean(false)
+{
+    // the content the snapshot key was computed from
+    for (auto &module : moduleNameVec) {
+        moduleHashes[module] = Hash::hashFiles({module});
+    }
+    inputHash = Hash::toHex(Hash::hashFiles(moduleNameVec));
+}
+
+Program::~Program()
+{
+    release();
+}
+
+void Program::release()
+{
+    published = 0;
+    bufferTypes.clear();
+    delete demandPTA;
+    delete callSiteIndex;
+    for (auto index : retiredIndexes) {
+        delete index;
+    }
+    retiredIndexes.clear();
+    delete svfgTable;
+    delete ptsCache;
+    delete vfg;
+    delete svfg;
+    delete svfBuilder;
+    // Andersen's analysis is released with the SVFIR
+    if (ptaKind != "andersen") {
+        delete pta;
+    }
+    callSiteIndex = NULL;
+    svfgTable = NULL;
+    ptsCache = NULL;
+    vfg = NULL;
+    svfg = NULL;
+    svfBuilder = NULL;
+    pta = NULL;
+    svfgNodes.clear();
+    if (pag != NULL) {
+        // also used as pre-analysis, it may exist without being selected
+        AndersenWaveDiff::releaseAndersenWaveDiff();
+        SVFIR::releaseSVFIR();
+    }
+    andersenBuilt = false;
+
+    //LLVMModuleSet::getLLVMModuleSet()->dumpModulesToFile(".svf.bc");
+    // the module set may belong to another program if this one was never built
+    if (svfModule != NULL) {
+        SVF::LLVMModuleSet::releaseLLVMModuleSet();
+    }
+    demandPTA = NULL;
+    pag = NULL;
+    svfModule = NULL;
+    icfgNodes.clear();
+    delete icfgTable;
+    icfgTable = NULL;
+    for (auto table : retiredICFGTables) {
+        delete table;
+    }
+    retiredICFGTables.clear();
+    delete valueIndex;
+    valueIndex = NULL;
+}
+
+vector<string> Program::rehashModules()
+{
+    vector<string> changed;
+    for (auto &module : moduleNameVec) {
+        uint64_t hash = Hash::hashFiles({module});
+        auto it = moduleHashes.find(module);
+        if (it == moduleHashes.end() || it->second != hash) {
+            moduleHashes[module] = hash;
+            changed.push_back(module);
+        }
+    }
+    if (!changed.empty()) {
+        string hash = Hash::toHex(Hash::hashFiles(moduleNameVec));
+        {
+            lock_guard<mutex> identity(identityMutex);
+            inputHash = hash;
+        }
+        if (snapshot != NULL) {
+            snapshot->update(moduleNameVec, ptaKind);
+        }
+    }
+    return changed;
+}
+
+unsigned int Program::getBuilt()
+{
+    unsigned int built = 0;
+    if (pag != NULL) {
+        built |= ICFG_ARTIFACT;
+    }
+    if (pta != NULL) {
+        built |= PTA_ARTIFACT | CALLGRAPH_ARTIFACT;
+    }
+    if (vfg != NULL) {
+        built |= VFG_ARTIFACT;
+    }
+    if (svfg != NULL) {
+        built |= SVFG_ARTIFACT;
+    }
+    if (demandPTA != NULL) {
+        built |= DDA_ARTIFACT;
+    }
+    return built;
+}
+
+/// SVF has no incremental solver, a changed module rebuilds the whole
+/// program. Modules which did not change are detected by their content
+/// hash, so reloading an unchanged tree keeps the graphs.
+bool Program::reload(const vector<string> &modules, raw_ostream &out)
+{
+    lock_guard<recursive_mutex> guard(buildMutex);
+    const vector<string> &check = modules.empty() ? moduleNameVec : modules;
+    for (auto &module : check) {
+        if (!sys::fs::exists(module)) {
+            out << "Error: could not find module " << module << "\n";
+            return false;
+        }
+    }
+    for (auto &module : check) {
+        if (find(moduleNameVec.begin(), moduleNameVec.end(), module) == moduleNameVec.end()) {
+            moduleNameVec.push_back(module);
+        }
+    }
+    // compared against the content the identity and the graphs refer to,
+    // also if the graphs were not built yet or were evicted
+    vector<string> changed = rehashModules();
+    if (changed.empty()) {
+        out << "no module changed\n";
+        return true;
+    }
+    for (auto &module : changed) {
+        out << "changed: " << module << "\n";
+    }
+    unsigned int built = getBuilt();
+    BuildStats::Timer timer(stats, "reload");
+    release();
+    touch();
+    timer.stop(changed.size());
+    require(built);
+    return true;
+}
+
+bool Program::tryEvict()
+{
+    unique_lock<shared_mutex> use(useMutex, try_to_lock);
+    if (!use.owns_lock()) {
+        return false;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    resident = false;
+    if (svfModule == NULL) {
+        return true;
+    }
+    SVFUtil::outs() << "evict program\n";
+    release();
+    touch();
+    if (lean) {
+        compact();
+    }
+    return true;
+}
+
+void Program::waitIdle()
+{
+    unique_lock<shared_mutex> use(useMutex);
+}
+
+void Program::activate()
+{
+    lock_guard<recursive_mutex> guard(buildMutex);
+    resident = true;
+    if (snapshot != NULL) {
+        snapshot->apply();
+    }
+}
+
+/// Artifacts are built in dependency order and published one by one, each
+/// together with its tables and indexes, so they are shared by forked
+/// workers and read without the build lock.
+void Program::require(unsigned int artifacts)
+{
+    if (isPublished(artifacts)) {
+        return;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    unsigned int built = getBuilt();
+    if (artifacts != 0) {
+        getICFGTable();
+        getICFGNodes();
+        getCallSiteIndex();
+        published |= ICFG_ARTIFACT;
+    }
+    if (artifacts & (PTA_ARTIFACT | CALLGRAPH_ARTIFACT | VFG_ARTIFACT | SVFG_ARTIFACT)) {
+        getCallGraph();
+        published |= PTA_ARTIFACT | CALLGRAPH_ARTIFACT;
+    }
+    if (artifacts & VFG_ARTIFACT) {
+        getVFG();
+        published |= VFG_ARTIFACT;
+    }
+    if (artifacts & SVFG_ARTIFACT) {
+        getSVFGTable();
+        getSVFGNodes();
+        published |= SVFG_ARTIFACT;
+    }
+    if (artifacts & DDA_ARTIFACT) {
+        getDemandPTA();
+        published |= DDA_ARTIFACT;
+    }
+    // workers forked before would build the new artifacts on their own
+    if (getBuilt() != built) {
+        touch();
+        if (lean) {
+            compact();
+        }
+    }
+}
+
+/// The solvers free their worklists and temporary graphs when they finish,
+/// glibc keeps the freed memory in the heap until it is trimmed
+void Program::compact()
+{
+    long before = BuildStats::getRSS();
+    BuildStats::Timer timer(stats, "compact");
+    malloc_trim(0);
+    timer.stop();
+    SVFUtil::outs() << format("compact: rss %.1f MB -> %.1f MB\n", before / 1024.0,
+                              BuildStats::getRSS() / 1024.0);
+}
+
+void Program::printStatus(raw_ostream &out)
+{
+    static const pair<unsigned int, const char*> artifacts[] = {
+        {ICFG_ARTIFACT, "icfg"}, {PTA_ARTIFACT, "pta"}, {CALLGRAPH_ARTIFACT, "callgraph"},
+        {VFG_ARTIFACT, "vfg"}, {SVFG_ARTIFACT, "svfg"}, {DDA_ARTIFACT, "dda"},
+    };
+    unsigned int ready = published;
+    out << "ready:";
+    for (auto &artifact : artifacts) {
+        if (ready & artifact.first) {
+            out << " " << artifact.second;
+        }
+    }
+    out << (ready == 0 ? " nothing" : "") << "\n";
+    for (auto &phase : stats.getRunning()) {
+        out << "building " << phase.name << " for " << format("%.0f", phase.wallTime) << " s\n";
+    }
+}
+
+pid_t Program::forkWorker()
+{
+    buildMutex.lock();
+    pid_t pid = fork();
+    if (pid == 0) {
+        // locks held by other threads of the server are never released
+        new (&buildMutex) recursive_mutex;
+        bufferTypes.resetLock();
+        stats.resetLock();
+        if (demandPTA != NULL) {
+            demandPTA->resetLock();
+        }
+        if (ptsCache != NULL) {
+            ptsCache.load()->resetLock();
+        }
+        return pid;
+    }
+    buildMutex.unlock();
+    return pid;
+}
+
+string Program::getIdentity()
+{
+    lock_guard<mutex> identity(identityMutex);
+    return inputHash + "-" + ptaKind + "-" + SVFOptions::getHash();
+}
+
+bool Program::selectAnalysis(const string &kind, raw_ostream &out)
+{
+    if (!isPTAKind(kind)) {
+        out << "Error: unknown pointer analysis: " << kind << "\n";
+        printAnalyses(out);
+        return false;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    // the graphs built so far are rebuilt with the new analysis
+    unsigned int built = getBuilt();
+    // every analysis, also Andersen's as pre-analysis of the demand-driven
+    // one, adds the indirect calls it resolved to the SVFIR and ICFG.
+    // Another analysis would build on them, so it starts from new graphs
+    if (kind != ptaKind && (pta != NULL || demandPTA != NULL)) {
+        SVFUtil::outs() << "release pointer analysis " << ptaKind << "\n";
+        release();
+    }
+    if (kind != ptaKind) {
+        {
+            lock_guard<mutex> identity(identityMutex);
+            ptaKind = kind;
+        }
+        // the snapshot is keyed by the analysis kind
+        if (snapshot != NULL) {
+            snapshot->update(moduleNameVec, ptaKind);
+        }
+    }
+    touch();
+    require(built | PTA_ARTIFACT);
+    out << "active pointer analysis: " << ptaKind << "\n";
+    return true;
+}
+
+void Program::printAnalyses(raw_ostream &out)
+{
+    string active;
+    {
+        lock_guard<mutex> identity(identityMutex);
+        active = ptaKind;
+    }
+    out << "pointer analyses:";
+    for (auto &kind : getPTAKinds()) {
+        out << " " << kind;
+        if (kind == active) {
+            out << " (active)";
+        }
+    }
+    out << "\n";
+}
+
+SVFIR* Program::getPAG()
+{
+    if (isPublished(ICFG_ARTIFACT)) {
+        return pag;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (pag != NULL) {
+        return pag;
+    }
+    BuildStats::Timer moduleTimer(stats, "module load");
+    if (Options::WriteAnder == "ir_annotator")
+    {
+        LLVMModuleSet::getLLVMModuleSet()->preProcessBCs(moduleNameVec);
+    }
+
+    SVFUtil::outs() << "init svf module...\n";
+    // the modules may have changed since the program was opened or evicted
+    rehashModules();
+    svfModule = LLVMModuleSet::getLLVMModuleSet()->buildSVFModule(moduleNameVec);
+    moduleTimer.stop(svfModule->getFunctionSet().size());
+    BuildStats::Timer symbolTimer(stats, "symbol table");
+    svfModule->buildSymbolTableInfo();
+    symbolTimer.stop();
+
+    /// Build Program Assignment Graph (SVFIR)
+    SVFIRBuilder builder;
+    SVFUtil::outs() << "build pag...\n";
+    BuildStats::Timer pagTimer(stats, "svfir");
+    pag = builder.build(svfModule);
+    pagTimer.stop(pag->getTotalNodeNum(), pag->getTotalEdgeNum());
+
+    // the ICFG is built as part of the SVFIR, only its size is recorded
+    ICFG *icfg = pag->getICFG();
+    BuildStats::Timer(stats, "icfg").stop(icfg->getTotalNodeNum(), icfg->getTotalEdgeNum());
+    return pag;
+}
+
+ICFG* Program::getICFG()
+{
+    return getPAG()->getICFG();
+}
+
+PointerAnalysis* Program::getPTA()
+{
+    if (isPublished(PTA_ARTIFACT)) {
+        return pta;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (pta != NULL) {
+        return pta;
+    }
+    SVFIR *pag = getPAG();
+
+    /// Create the selected pointer analysis
+    SVFUtil::outs() << "running pointer analysis " << ptaKind << "...\n";
+    // snapshots only hold the results of Andersen's analysis
+    if (snapshot != NULL) {
+        snapshot->setEnabled(ptaKind == "andersen");
+    }
+    BuildStats::Timer ptaTimer(stats, ptaKind);
+    // only a new singleton is written to the snapshot
+    bool writesAnder = ptaKind == "andersen" && !andersenBuilt;
+    if (ptaKind == "andersen" || ptaKind == "fs" || ptaKind == "fstbhc") {
+        andersenBuilt = true;
+    }
+    pta = createPTA(ptaKind, pag);
+    if (ptaKind == "fs" || ptaKind == "fstbhc") {
+        ptaTimer.stop();
+    } else {
+        ConstraintGraph *consCG = static_cast<AndersenBase*>(pta)->getConstraintGraph();
+        ptaTimer.stop(consCG->getTotalNodeNum(), consCG->getTotalEdgeNum());
+    }
+
+    // the call graph is resolved on the fly by the solver, only its size is recorded
+    PTACallGraph *callgraph = pta->getPTACallGraph();
+    BuildStats::Timer(stats, "callgraph").stop(callgraph->getTotalNodeNum(), callgraph->getTotalEdgeNum());
+    if (snapshot != NULL) {
+        if (writesAnder) {
+            snapshot->commit("ander");
+        }
+        snapshot->setEnabled(true);
+    }
+    // the solver added the indirect call and return edges to the ICFG
+    if (callSiteIndex != NULL) {
+        updateCallSiteIndex();
+    }
+    if (icfgTable != NULL) {
+        updateICFGTable();
+    }
+
+    return pta;
+}
+
+PTACallGraph* Program::getCallGraph()
+{
+    return getPTA()->getPTACallGraph();
+}
+
+VFG* Program::getVFG()
+{
+    if (isPublished(VFG_ARTIFACT)) {
+        return vfg;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (vfg != NULL) {
+        return vfg;
+    }
+    PTACallGraph *callgraph = getCallGraph();
+
+    /// Value-Flow Graph (VFG)
+    SVFUtil::outs() << "create VFG...\n";
+    BuildStats::Timer timer(stats, "vfg");
+    vfg = new VFG(callgraph);
+    timer.stop(vfg->getTotalNodeNum(), vfg->getTotalEdgeNum());
+    return vfg;
+}
+
+SVFG* Program::getSVFG()
+{
+    if (isPublished(SVFG_ARTIFACT)) {
+        return svfg;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (svfg != NULL) {
+        return svfg;
+    }
+    getPTA();
+
+    /// Sparse value-flow graph (SVFG)
+    SVFUtil::outs() << "create svfg...\n";
+    if (snapshot != NULL) {
+        snapshot->setEnabled(ptaKind == "andersen");
+    }
+    //svfg = svfBuilder.buildFullSVFGWithoutOPT((BVDataPTAImpl*)pta);
+    BuildStats::Timer timer(stats, "svfg");
+    svfBuilder = new SVFGBuilder;
+    svfg = svfBuilder->buildFullSVFG((BVDataPTAImpl*)pta);
+    timer.stop(svfg->getTotalNodeNum(), svfg->getTotalEdgeNum());
+    if (snapshot != NULL) {
+        if (ptaKind == "andersen") {
+            snapshot->commit("svfg");
+        }
+        snapshot->setEnabled(true);
+    }
+    return svfg;
+}
+
+DemandPTA* Program::getDemandPTA()
+{
+    if (isPublished(DDA_ARTIFACT)) {
+        return demandPTA;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (demandPTA != NULL) {
+        return demandPTA;
+    }
+    SVFIR *pag = getPAG();
+
+    /// ContextDDA runs Andersen's analysis as pre-analysis and builds a
+    /// pointer-only SVFG, queries refine it on demand
+    SVFUtil::outs() << "init demand-driven analysis...\n";
+    BuildStats::Timer timer(stats, "dda");
+    bool writesAnder = !andersenBuilt;
+    andersenBuilt = true;
+    demandPTA = new DemandPTA(svfModule, pag, demandBudget);
+    timer.stop();
+    // the snapshot options are enabled outside of getPTA
+    if (snapshot != NULL && writesAnder) {
+        snapshot->commit("ander");
+    }
+    // a new pre-analysis added its indirect calls to the ICFG
+    if (writesAnder && icfgTable != NULL) {
+        updateICFGTable();
+    }
+    return demandPTA;
+}
+
+bool Program::getPointer(const Value *value, NodeID &ptr)
+{
+    SVFIR *pag = getPAG();
+    if (!pag->hasValueNode(value)) {
+        return false;
+    }
+    ptr = pag->getValueNode(value);
+    return pag->getGNode(ptr)->isPointer();
+}
+
+bool Program::getDemandPointsTo(const Value *value, PointsTo &pts, unsigned int budget)
+{
+    DemandPTA *dda = getDemandPTA();
+    pts.clear();
+    NodeID ptr;
+    if (!getPointer(value, ptr)) {
+        return false;
+    }
+    return dda->getPointsTo(ptr, pts, budget);
+}
+
+DemandResult Program::mayAlias(const Value *a, const Value *b, unsigned int budget)
+{
+    DemandPTA *dda = getDemandPTA();
+    NodeID ptrA, ptrB;
+    if (!getPointer(a, ptrA) || !getPointer(b, ptrB)) {
+        return DEMAND_MAY;
+    }
+    // the result of the pre-analysis is a superset, disjoint sets are an
+    // answer even if a query ran out of budget
+    PointsTo ptsA, ptsB;
+    bool complete = dda->getPointsTo(ptrA, ptsA, budget);
+    complete &= dda->getPointsTo(ptrB, ptsB, budget);
+    if (!ptsA.intersects(ptsB)) {
+        return DEMAND_NO;
+    }
+    return complete ? DEMAND_MAY : DEMAND_OUT_OF_BUDGET;
+}
+
+DemandResult Program::mayFlow(const Value *from, const Value *to, unsigned int budget)
+{
+    DemandPTA *dda = getDemandPTA();
+    NodeID src, dst;
+    if (!getPointer(from, src) || !getPointer(to, dst)) {
+        return DEMAND_NO;
+    }
+    bool reached;
+    if (!dda->mayFlow(src, dst, budget, reached)) {
+        return DEMAND_OUT_OF_BUDGET;
+    }
+    return reached ? DEMAND_MAY : DEMAND_NO;
+}
+
+// status commands do not wait for a build: the published analysis is only
+// released while the graphs are locked exclusively
+void Program::printDemandStats(raw_ostream &os)
+{
+    shared_lock<shared_mutex> use(useMutex, try_to_lock);
+    if (use.owns_lock() && isPublished(DDA_ARTIFACT)) {
+        demandPTA->printStats(os);
+    }
+}
+
+const ValueIndex& Program::getValueIndex()
+{
+    ValueIndex *index = valueIndex;
+    if (index != NULL) {
+        return *index;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (valueIndex == NULL) {
+        SVFIR *pag = getPAG();
+        BuildStats::Timer timer(stats, "value index");
+        valueIndex = new ValueIndex(svfModule, pag);
+        timer.stop();
+    }
+    return *valueIndex;
+}
+
+PointsToCache& Program::getPointsToCache()
+{
+    if (isPublished(PTA_ARTIFACT)) {
+        PointsToCache *cache = ptsCache;
+        if (cache != NULL) {
+            return *cache;
+        }
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (ptsCache == NULL) {
+        ptsCache = new PointsToCache(getPAG(), getPTA(), queryCacheMemory);
+    }
+    return *ptsCache.load();
+}
+
+bool Program::findValues(const string &id, vector<const Value*> &values)
+{
+    return getValueIndex().find(id, values);
+}
+
+void Program::queryPointsTo(const vector<const Value*> &values, vector<PointsTo> &pts)
+{
+    PointsToCache &cache = getPointsToCache();
+    vector<NodeID> objects;
+    pts.assign(values.size(), PointsTo());
+    for (size_t i = 0; i < values.size(); i++) {
+        NodeID ptr;
+        if (!getPointer(values[i], ptr)) {
+            continue;
+        }
+        objects.clear();
+        cache.get(ptr)->getObjects(objects);
+        for (NodeID obj : objects) {
+            pts[i].set(obj);
+        }
+    }
+}
+
+void Program::queryAliases(const vector<ValuePair> &pairs, vector<bool> &aliases)
+{
+    PointsToCache &cache = getPointsToCache();
+    aliases.assign(pairs.size(), false);
+    for (size_t i = 0; i < pairs.size(); i++) {
+        NodeID a, b;
+        if (getPointer(pairs[i].first, a) && getPointer(pairs[i].second, b)) {
+            aliases[i] = cache.mayAlias(a, b);
+        }
+    }
+}
+
+string Program::getObjectName(NodeID obj)
+{
+    SVFIR *pag = getPAG();
+    if (obj == pag->getBlackHoleNode()) {
+        return "unknown";
+    }
+    PAGNode *node = pag->getGNode(obj);
+    string name = node->hasValue() ? ValueIndex::getName(node->getValue()) : "";
+    return name.empty() ? "#" + to_string(obj) : name;
+}
+
+/// The fields of an object are separate objects with the name of the
+/// object, each name is printed once
+bool Program::printPointsTo(const list<string> &ids, raw_ostream &out)
+{
+    const ValueIndex &index = getValueIndex();
+    PointsToCache &cache = getPointsToCache();
+    SVFIR *pag = getPAG();
+    bool ok = true;
+    vector<const Value*> values;
+    vector<NodeID> objects;
+    for (auto &id : ids) {
+        values.clear();
+        if (!index.find(id, values)) {
+            out << "Error: unknown value " << id << "\n";
+            ok = false;
+            continue;
+        }
+        objects.clear();
+        for (const Value *value : values) {
+            cache.get(pag->getValueNode(value))->getObjects(objects);
+        }
+        std::sort(objects.begin(), objects.end());
+        objects.erase(unique(objects.begin(), objects.end()), objects.end());
+        out << id << ":";
+        unordered_set<string> printed;
+        for (NodeID obj : objects) {
+            string name = getObjectName(obj);
+            if (printed.insert(name).second) {
+                out << " " << name;
+            }
+        }
+        out << "\n";
+    }
+    return ok;
+}
+
+/// An identifier with several values, e.g. a source location, may alias if
+/// any of its values may alias
+bool Program::printAliases(const list<string> &ids, raw_ostream &out)
+{
+    if (ids.size() % 2 != 0) {
+        out << "Error: alias takes pairs of values\n";
+        return false;
+    }
+    const ValueIndex &index = getValueIndex();
+    PointsToCache &cache = getPointsToCache();
+    SVFIR *pag = getPAG();
+    bool ok = true;
+    vector<const Value*> valuesA, valuesB;
+    for (auto it = ids.begin(); it != ids.end(); it++) {
+        const string &a = *it++;
+        const string &b = *it;
+        valuesA.clear();
+        valuesB.clear();
+        bool found = true;
+        if (!index.find(a, valuesA)) {
+            out << "Error: unknown value " << a << "\n";
+            found = false;
+        }
+        if (!index.find(b, valuesB)) {
+            out << "Error: unknown value " << b << "\n";
+            found = false;
+        }
+        if (!found) {
+            ok = false;
+            continue;
+        }
+        bool alias = false;
+        for (size_t i = 0; i < valuesA.size() && !alias; i++) {
+            for (size_t j = 0; j < valuesB.size() && !alias; j++) {
+                alias = cache.mayAlias(pag->getValueNode(valuesA[i]), pag->getValueNode(valuesB[j]));
+            }
+        }
+        out << a << " " << b << ": " << (alias ? "may" : "no") << "\n";
+    }
+    return ok;
+}
+
+void Program::printQueryStats(raw_ostream &os)
+{
+    shared_lock<shared_mutex> use(useMutex, try_to_lock);
+    PointsToCache *cache = ptsCache;
+    if (use.owns_lock() && cache != NULL) {
+        cache->printStats(os);
+    }
+}
+
+CallSiteIndex* Program::getCallSiteIndex()
+{
+    if (isPublished(ICFG_ARTIFACT)) {
+        return callSiteIndex;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    return updateCallSiteIndex();
+}
+
+CallSiteIndex* Program::updateCallSiteIndex()
+{
+    CallSiteIndex *index = callSiteIndex;
+    if (index == NULL) {
+        index = new CallSiteIndex(getICFG());
+        callSiteIndex = index;
+    }
+    // indirect targets are only known once the pointer analysis ran, runs
+    // may read the published index meanwhile, so a copy gets them
+    if (pta != NULL && !index->hasIndirectCalls()) {
+        CallSiteIndex *indirect = new CallSiteIndex(*index);
+        indirect->addIndirectCalls(pta->getPTACallGraph());
+        retiredIndexes.push_back(index);
+        callSiteIndex = indirect;
+        index = indirect;
+    }
+    return index;
+}
+
+const CallSiteList& Program::getCallSites(const string &callee)
+{
+    return getCallSiteIndex()->getCallSites(callee);
+}
+
+void Program::getCallSitesByPrefix(const string &prefix, CallSiteList &callSites)
+{
+    getCallSiteIndex()->getCallSitesByPrefix(prefix, callSites);
+}
+
+const ICFGNodeTable& Program::getICFGTable()
+{
+    if (isPublished(ICFG_ARTIFACT)) {
+        return *icfgTable.load();
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (icfgTable == NULL) {
+        ICFG *icfg = getICFG();
+        BuildStats::Timer timer(stats, "icfg table");
+        icfgTable = new ICFGNodeTable(icfg);
+        timer.stop(icfgTable.load()->size());
+    }
+    return *icfgTable.load();
+}
+
+// the degrees of call and return nodes change, runs may read the published
+// table meanwhile, so a new one replaces it. The pointer analysis adds no
+// nodes, the node list stays valid
+void Program::updateICFGTable()
+{
+    BuildStats::Timer timer(stats, "icfg table");
+    ICFGNodeTable *table = new ICFGNodeTable(getICFG());
+    retiredICFGTables.push_back(icfgTable);
+    icfgTable = table;
+    timer.stop(table->size());
+}
+
+const SVFGNodeTable& Program::getSVFGTable()
+{
+    if (isPublished(SVFG_ARTIFACT)) {
+        return *svfgTable;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (svfgTable == NULL) {
+        SVFG *svfg = getSVFG();
+        BuildStats::Timer timer(stats, "svfg table");
+        svfgTable = new SVFGNodeTable(svfg);
+        timer.stop(svfgTable->size());
+    }
+    return *svfgTable;
+}
+
+const vector<const ICFGNode*>& Program::getICFGNodes()
+{
+    if (isPublished(ICFG_ARTIFACT)) {
+        return icfgNodes;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (icfgNodes.empty()) {
+        ICFG *icfg = getICFG();
+        icfgNodes.reserve(icfg->getTotalNodeNum());
+        for (ICFG::iterator i = icfg->begin(); i != icfg->end(); i++) {
+            icfgNodes.push_back(i->second);
+        }
+    }
+    return icfgNodes;
+}
+
+const vector<const VFGNode*>& Program::getSVFGNodes()
+{
+    if (isPublished(SVFG_ARTIFACT)) {
+        return svfgNodes;
+    }
+    lock_guard<recursive_mutex> guard(buildMutex);
+    if (svfgNodes.empty()) {
+        SVFG *svfg = getSVFG();
+        svfgNodes.reserve(svfg->getTotalNodeNum());
+        for (SVFG::iterator i = svfg->begin(); i != svfg->end(); i++) {
+            svfgNodes.push_back(i->second);
+        }
+    }
+    return svfgNodes;
+}
+
+// the visitors may call back into the program from other threads, so the
+// build lock is only held while the nodes are collected
+void Program::parallelForICFG(const ICFGNodeVisitor &visitor, ResultSink &sink)
+{
+    parallelForNodes(getICFGNodes(), visitor, sink);
+}
+
+void Program::parallelForSVFG(const SVFGNodeVisitor &visitor, ResultSink &sink)
+{
+    parallelForNodes(getSVFGNodes(), visitor, sink);
+}
+
+// the nodes come from the kind index, the others are not touched
+void Program::parallelForICFGKind(unsigned int kind, const ICFGNodeVisitor &visitor, ResultSink &sink)
+{
+    const ICFGNodeTable &table = getICFGTable();
+    ICFGNodeTable::Range range = table.getKindRange(kind);
+    parallelForShards(range.end - range.begin, [&](size_t i, ResultSink &shard) {
+        visitor(table.getNode(table.getKindRow(range.begin + i)), shard);
+    }, sink);
+}
+
+string Program::parseChecker(const string &spec, list<string> &args)
+{
+    size_t eq = spec.find('=');
+    if (eq == string::npos) {
+        return spec;
+    }
+    size_t begin = eq + 1;
+    while (begin <= spec.size()) {
+        size_t end = spec.find(',', begin);
+        if (end == string::npos) {
+            end = spec.size();
+        }
+        if (end > begin) {
+            args.push_back(spec.substr(begin, end - begin));
+        }
+        begin = end + 1;
+    }
+    return spec.substr(0, eq);
+}
+
+bool Program::runCheckers(Plugin *plugin, const list<string> &names, ResultSink &sink)
+{
+    vector<CheckerVisitors> checkers(names.size());
+    size_t c = 0;
+    for (auto &spec : names) {
+        list<string> args;
+        string name = parseChecker(spec, args);
+        if (!plugin->registerChecker(name, args, checkers[c++])) {
+            sink.text() << "Error: " << name << " is no checker\n";
+            return false;
+        }
+    }
+
+    // one pass over each graph, a graph no checker visits is not built
+    vector<vector<BufferedSink>> icfgOutput, svfgOutput;
+    fusedForNodes<ICFGNode>(checkers, &CheckerVisitors::getICFGVisitors,
+                            [this]() -> const vector<const ICFGNode*>& { return getICFGNodes(); },
+                            icfgOutput);
+    fusedForNodes<VFGNode>(checkers, &CheckerVisitors::getSVFGVisitors,
+                           [this]() -> const vector<const VFGNode*>& { return getSVFGNodes(); },
+                           svfgOutput);
+
+    // the output is ordered as if the checkers ran one after the other
+    for (c = 0; c < checkers.size(); c++) {
+        for (auto *output : {&icfgOutput, &svfgOutput}) {
+            for (auto &shard : *output) {
+                shard[c].finish();
+                shard[c].replay(sink);
+            }
+        }
+        for (auto &finisher : checkers[c].getFinishers()) {
+            finisher(sink);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,287 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "SVF-FE/SVFIRBuilder.h"
+#include "WPA/Andersen.h"
+#include "MSSA/SVFGBuilder.h"
+#include "svf-plugin.h"
+#include "Snapshot.h"
+#include "CallSiteIndex.h"
+#include "BufferTypeIndex.h"
+#include "DemandPTA.h"
+#include "PointsToCache.h"
+#include "ValueIndex.h"
+#include "WorkerPool.h"
+#include <atomic>
+#include "BuildStats.h"
+#include "ResultCache.h"
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+/// The analyzed program. All graphs are built lazily, in dependency order,
+/// the first time they are requested and kept until the program is released.
+/// The accessors are thread-safe, a build blocks concurrent accessors until
+/// it is finished. Artifacts which are already published are accessed
+/// without waiting for the build of others.
+///
+/// One pointer analysis is built on the SVFIR. It adds the indirect calls to
+/// the SVFIR and ICFG, so selecting another one is a full reload: all graphs
+/// are released and built again.
+class Program : public SVFServer
+{
+private:
+    std::vector<std::string> moduleNameVec;
+    /// content hash of every module the identity, the snapshot key and the
+    /// graphs refer to
+    std::map<std::string, uint64_t> moduleHashes;
+    Snapshot *snapshot;
+    ResultCache *resultCache;
+    /// hash of the input files, computed when the program is opened and
+    /// when a module changes
+    std::string inputHash;
+
+    SVF::SVFModule *svfModule;
+    SVF::SVFIR *pag;
+    SVF::PointerAnalysis *pta;
+    SVF::VFG *vfg;
+    SVF::SVFG *svfg;
+    SVF::SVFGBuilder *svfBuilder;
+    std::string ptaKind;
+    /// guards inputHash and changes of ptaKind, so the identity is read
+    /// without waiting for a build
+    std::mutex identityMutex;
+    /// Andersen's singleton exists, it is built by the first analysis which
+    /// needs it: Andersen's, flow-sensitive or demand-driven
+    bool andersenBuilt;
+    BufferTypeIndex bufferTypes;
+    DemandPTA *demandPTA;
+    unsigned int demandBudget;
+    unsigned int queryCacheMemory;
+    std::vector<const SVF::ICFGNode*> icfgNodes;
+    std::vector<const SVF::VFGNode*> svfgNodes;
+    /// replaced when the indirect calls are added, runs read it unlocked
+    std::atomic<CallSiteIndex*> callSiteIndex;
+    std::vector<CallSiteIndex*> retiredIndexes;
+    SVFGNodeTable *svfgTable;
+    std::atomic<PointsToCache*> ptsCache;
+    /// replaced when the indirect calls are added, runs read it unlocked
+    std::atomic<ICFGNodeTable*> icfgTable;
+    std::vector<ICFGNodeTable*> retiredICFGTables;
+    std::atomic<ValueIndex*> valueIndex;
+    std::recursive_mutex buildMutex;
+    /// Artifacts of the active analysis which are completely built. They
+    /// are read without taking buildMutex, so a run does not wait for the
+    /// build of an artifact it does not use.
+    std::atomic<unsigned int> published;
+    /// changed whenever forked workers would see outdated state
+    std::atomic<unsigned long> generation;
+    WorkerPool *workerPool;
+    /// held shared while a run uses the graphs, exclusively by reload
+    std::shared_mutex useMutex;
+    /// cleared by tryEvict, runs check it once they hold useMutex
+    std::atomic<bool> resident;
+    BuildStats stats;
+    bool lean;
+
+    SVF::SVFIR* getPAG();
+    DemandPTA* getDemandPTA();
+    /// artifacts which are built at the moment
+    unsigned int getBuilt();
+    /// drop all graphs and the LLVM modules, useMutex is held exclusively
+    void release();
+    /// hash the modules again and return those whose content changed,
+    /// the identity and the snapshot key follow the new content
+    std::vector<std::string> rehashModules();
+    /// return freed memory to the system, used in lean mode
+    void compact();
+    CallSiteIndex* getCallSiteIndex();
+    /// built on the first query
+    const ValueIndex& getValueIndex();
+    PointsToCache& getPointsToCache();
+    /// pointer node of value, false if it is no pointer
+    bool getPointer(const llvm::Value *value, SVF::NodeID &ptr);
+    /// name of an object node as printed by printPointsTo
+    std::string getObjectName(SVF::NodeID obj);
+    /// create the call site index or add the indirect calls, buildMutex is held
+    CallSiteIndex* updateCallSiteIndex();
+    /// build the ICFG table again after the indirect calls were added to
+    /// the ICFG, buildMutex is held
+    void updateICFGTable();
+    /// nodes of the graphs in ID order, for sharded traversals
+    const std::vector<const SVF::ICFGNode*>& getICFGNodes();
+    const std::vector<const SVF::VFGNode*>& getSVFGNodes();
+
+public:
+    Program(const std::vector<std::string> &moduleNameVec, Snapshot *snapshot,
+            ResultCache *resultCache, const std::string &ptaKind);
+    ~Program();
+
+    /// build all artifacts (bitwise or of Artifact) which are not built yet
+    void require(unsigned int artifacts);
+    /// true if all artifacts are built and can be used without waiting
+    bool isPublished(unsigned int artifacts) const {
+        return (published & artifacts) == artifacts;
+    }
+    /// true if building artifacts runs a pointer analysis, which adds the
+    /// indirect calls to the SVFIR and ICFG runs may read meanwhile
+    bool changesGraphs(unsigned int artifacts) const {
+        unsigned int needed = artifacts & DDA_ARTIFACT;
+        if (artifacts & (PTA_ARTIFACT | CALLGRAPH_ARTIFACT | VFG_ARTIFACT | SVFG_ARTIFACT)) {
+            needed |= PTA_ARTIFACT;
+        }
+        return !isPublished(needed);
+    }
+    /// print the published artifacts and the phases being built
+    void printStatus(llvm::raw_ostream &out);
+
+    /// Replace the given modules (all if empty) by their current content on
+    /// disk, modules which are not part of the program yet are added. If any
+    /// module changed, the graphs are dropped and the artifacts which were
+    /// built before are rebuilt. The caller holds lockGraphsExclusive.
+    bool reload(const std::vector<std::string> &modules, llvm::raw_ostream &out);
+    const std::vector<std::string>& getModules() const {
+        return moduleNameVec;
+    }
+
+    /// Drop all graphs so that another program can be built, they are
+    /// rebuilt on demand. Returns false without waiting if runs or builds
+    /// use the graphs.
+    bool tryEvict();
+    /// wait until no run or build uses the graphs
+    void waitIdle();
+    /// apply the snapshot options of this program before it is built, they
+    /// are process-wide
+    void activate();
+    /// true between activate and tryEvict
+    bool isResident() const {
+        return resident;
+    }
+
+    /// pointer analyses which can be selected
+    static const std::vector<std::string>& getPTAKinds();
+    static bool isPTAKind(const std::string &kind);
+    /// Make kind the active pointer analysis. All graphs are released and
+    /// those built before are built again with it. The caller holds
+    /// lockGraphsExclusive.
+    bool selectAnalysis(const std::string &kind, llvm::raw_ostream &out);
+    /// list the pointer analyses and the active one
+    void printAnalyses(llvm::raw_ostream &out);
+
+    /// Fork a worker process which shares the graphs copy-on-write. No
+    /// graph is built while forking, the child gets fresh locks.
+    pid_t forkWorker();
+    unsigned long getGeneration() const {
+        return generation;
+    }
+    /// mark all forked workers outdated, e.g. after a plugin was loaded
+    void touch() {
+        generation++;
+    }
+    /// run plugins in worker processes, NULL runs them in the server
+    void setWorkerPool(WorkerPool *pool) {
+        workerPool = pool;
+    }
+    WorkerPool* getWorkerPool() {
+        return workerPool;
+    }
+
+    /// keeps the graphs from being reloaded while the lock is held
+    std::shared_lock<std::shared_mutex> lockGraphs() {
+        return std::shared_lock<std::shared_mutex>(useMutex);
+    }
+    /// keeps runs from using the graphs while the lock is held, e.g. while
+    /// the pointer analysis adds the indirect calls to the SVFIR and ICFG
+    std::unique_lock<std::shared_mutex> lockGraphsExclusive() {
+        return std::unique_lock<std::shared_mutex>(useMutex);
+    }
+
+    const BuildStats& getStats() const {
+        return stats;
+    }
+
+    /// Lean mode returns the memory of finished builds to the system
+    void setLean(bool enabled) {
+        lean = enabled;
+    }
+
+    /// default budget of demand-driven queries, 0 keeps SVF's -cxtbg
+    void setDemandBudget(unsigned int budget) {
+        demandBudget = budget;
+    }
+    /// query statistics of the demand-driven analysis, if it is built and
+    /// the graphs are not being rebuilt
+    void printDemandStats(llvm::raw_ostream &os);
+
+    /// size limit in MB of the points-to sets cached for queries
+    void setQueryCacheMemory(unsigned int size) {
+        queryCacheMemory = size;
+    }
+    /// Answer the pts and alias commands: the points-to set of every
+    /// identifier of ids, or whether the identifiers of every pair of ids
+    /// may alias. Returns false if an identifier is unknown. Requires
+    /// PTA_ARTIFACT.
+    bool printPointsTo(const std::list<std::string> &ids, llvm::raw_ostream &out);
+    bool printAliases(const std::list<std::string> &ids, llvm::raw_ostream &out);
+    void printQueryStats(llvm::raw_ostream &os);
+
+    /// content hash of the input bitcode, the active pointer analysis and
+    /// the command line options, identifies the graphs built from them
+    std::string getIdentity();
+    ResultCache* getResultCache() {
+        return resultCache;
+    }
+
+    SVF::ICFG* getICFG();
+    SVF::PTACallGraph* getCallGraph();
+    SVF::PointerAnalysis* getPTA();
+    SVF::SVFG* getSVFG();
+    SVF::VFG* getVFG();
+
+    const CallSiteList& getCallSites(const std::string &callee);
+    void getCallSitesByPrefix(const std::string &prefix, CallSiteList &callSites);
+    const ICFGNodeTable& getICFGTable();
+    const SVFGNodeTable& getSVFGTable();
+    llvm::Type* getBufferType(const llvm::Value *value) {
+        return bufferTypes.getBufferType(value);
+    }
+    bool getDemandPointsTo(const llvm::Value *value, SVF::PointsTo &pts, unsigned int budget);
+    DemandResult mayAlias(const llvm::Value *a, const llvm::Value *b, unsigned int budget);
+    DemandResult mayFlow(const llvm::Value *from, const llvm::Value *to, unsigned int budget);
+    bool findValues(const std::string &id, std::vector<const llvm::Value*> &values);
+    void queryPointsTo(const std::vector<const llvm::Value*> &values, std::vector<SVF::PointsTo> &pts);
+    void queryAliases(const std::vector<ValuePair> &pairs, std::vector<bool> &aliases);
+
+    void parallelForICFG(const ICFGNodeVisitor &visitor, ResultSink &sink);
+    void parallelForSVFG(const SVFGNodeVisitor &visitor, ResultSink &sink);
+    void parallelForICFGKind(unsigned int kind, const ICFGNodeVisitor &visitor, ResultSink &sink);
+
+    /// Run the checkers names of plugin in one traversal of the ICFG and
+    /// SVFG, the output is written to sink checker by checker. A name may
+    /// pass arguments to its checker as name=arg1,arg2. Returns false if a
+    /// name is no checker of plugin.
+    bool runCheckers(Plugin *plugin, const std::list<std::string> &names, ResultSink &sink);
+    /// split name=arg1,arg2 of run-all into the checker and its arguments
+    static std::string parseChecker(const std::string &spec, std::list<std::string> &args);
+};
+
+#endif // PROGRAM_H
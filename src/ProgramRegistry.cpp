@@ -0,0 +1,199 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ProgramRegistry.h"
+#include "Snapshot.h"
+#include "WorkerPool.h"
+#include "llvm/Support/FileSystem.h"
+
+using namespace llvm;
+using namespace std;
+
+ProgramRegistry::ProgramRegistry(const Config &config) : config(config), building(false)
+{
+}
+
+ProgramRegistry::~ProgramRegistry()
+{
+    if (builder.joinable()) {
+        builder.join();
+    }
+    lock_guard<recursive_mutex> guard(lock);
+    programs.clear();
+}
+
+bool ProgramRegistry::open(const string &name, const vector<string> &modules, raw_ostream &out)
+{
+    lock_guard<recursive_mutex> guard(lock);
+    if (programs.count(name) > 0) {
+        out << "Error: program " << name << " is already open\n";
+        return false;
+    }
+    for (auto &module : modules) {
+        if (!sys::fs::exists(module)) {
+            out << "Error: could not find module " << module << "\n";
+            return false;
+        }
+    }
+
+    Snapshot *snapshot = NULL;
+    if (!config.snapshotIn.empty() || !config.snapshotOut.empty()) {
+        snapshot = new Snapshot(config.snapshotIn, config.snapshotOut, modules, config.ptaKind);
+    }
+    Program *program = new Program(modules, snapshot, config.resultCache, config.ptaKind);
+    program->setDemandBudget(config.demandBudget);
+    program->setLean(config.lean);
+    program->setQueryCacheMemory(config.queryCacheMemory);
+    WorkerPool *workers = NULL;
+    if (config.workers > 0) {
+        workers = new WorkerPool(program, config.workers, config.workerTimeout, config.workerMemory);
+        program->setWorkerPool(workers);
+    }
+    // a program may hold the SVF singletons until it is deleted, so it is
+    // deleted under the lock like an eviction
+    programs[name] = shared_ptr<Program>(program, [this, snapshot, workers](Program *program) {
+        lock_guard<recursive_mutex> guard(lock);
+        delete workers;
+        delete program;
+        delete snapshot;
+    });
+    return true;
+}
+
+bool ProgramRegistry::close(const string &name, raw_ostream &out)
+{
+    lock_guard<recursive_mutex> guard(lock);
+    if (programs.erase(name) == 0) {
+        out << "Error: no program " << name << "\n";
+        return false;
+    }
+    return true;
+}
+
+shared_ptr<Program> ProgramRegistry::get(const string &name)
+{
+    lock_guard<recursive_mutex> guard(lock);
+    auto it = programs.find(name);
+    if (it == programs.end()) {
+        return shared_ptr<Program>();
+    }
+    return it->second;
+}
+
+void ProgramRegistry::print(raw_ostream &out, const Program *current)
+{
+    lock_guard<recursive_mutex> guard(lock);
+    shared_ptr<Program> active = resident.lock();
+    for (auto &it : programs) {
+        out << (it.second.get() == current ? "* " : "  ") << it.first << " ("
+            << it.second->getModules().size() << " modules"
+            << (it.second == active ? ", resident" : "") << ")\n";
+    }
+}
+
+unique_lock<recursive_mutex> ProgramRegistry::activate(const shared_ptr<Program> &program)
+{
+    while (true) {
+        unique_lock<recursive_mutex> guard(lock);
+        shared_ptr<Program> current = resident.lock();
+        if (current == program) {
+            return guard;
+        }
+        if (!current || current->tryEvict()) {
+            resident = program;
+            program->activate();
+            return guard;
+        }
+        // other sessions go on meanwhile, e.g. with the resident program
+        guard.unlock();
+        current->waitIdle();
+    }
+}
+
+// the program may be evicted while the graph lock is awaited, it is
+// activated again then
+shared_lock<shared_mutex> ProgramRegistry::acquire(const shared_ptr<Program> &program,
+                                                   unsigned int artifacts)
+{
+    while (true) {
+        if (program->changesGraphs(artifacts)) {
+            auto graphs = acquireExclusive(program);
+            program->require(artifacts);
+        }
+        activate(program);
+        auto graphs = program->lockGraphs();
+        // released again, e.g. by a reload, before the shared lock was taken
+        if (program->isResident() && !program->changesGraphs(artifacts)) {
+            program->require(artifacts);
+            return graphs;
+        }
+    }
+}
+
+unique_lock<shared_mutex> ProgramRegistry::acquireExclusive(const shared_ptr<Program> &program)
+{
+    while (true) {
+        activate(program);
+        auto graphs = program->lockGraphsExclusive();
+        if (program->isResident()) {
+            return graphs;
+        }
+    }
+}
+
+/// The stages are built like the requirements of a run, so runs which need
+/// a published artifact go on while later ones are built. The pointer
+/// analysis connects the indirect calls in the SVFIR and ICFG, the runs
+/// wait for this stage.
+void ProgramRegistry::prebuild(const shared_ptr<Program> &program)
+{
+    if (builder.joinable()) {
+        builder.join();
+    }
+    building = true;
+    builder = thread([this, program]() {
+        static const unsigned int stages[] = {
+            ICFG_ARTIFACT, PTA_ARTIFACT | CALLGRAPH_ARTIFACT, SVFG_ARTIFACT,
+        };
+        for (unsigned int artifacts : stages) {
+            // a later stage would evict the program another session uses now
+            if (artifacts != ICFG_ARTIFACT) {
+                lock_guard<recursive_mutex> guard(lock);
+                if (resident.lock() != program) {
+                    break;
+                }
+            }
+            if (program->changesGraphs(artifacts)) {
+                auto graphs = program->lockGraphsExclusive();
+                if (!program->isResident()) {
+                    break;
+                }
+                program->require(artifacts);
+            } else {
+                if (artifacts == ICFG_ARTIFACT) {
+                    activate(program);
+                }
+                auto graphs = program->lockGraphs();
+                if (!program->isResident()) {
+                    break;
+                }
+                program->require(artifacts);
+            }
+        }
+        building = false;
+    });
+}
@@ -0,0 +1,106 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROGRAMREGISTRY_H
+#define PROGRAMREGISTRY_H
+
+#include "Program.h"
+#include "ResultCache.h"
+#include "llvm/Support/raw_ostream.h"
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// The analyzed programs of the server, by name. Every session works on one
+/// of them and switches with use.
+///
+/// SVF keeps the SVFIR, the LLVM modules and Andersen's analysis in
+/// process-wide singletons, so only one program, the resident one, can hold
+/// graphs at a time. Before another program is used, the resident program is
+/// evicted: its graphs are released and rebuilt on demand when it is used
+/// again, Andersen's results and the SVFG are then restored from its
+/// snapshot if snapshots are enabled. A closed program is deleted once no
+/// session uses it any more.
+class ProgramRegistry
+{
+public:
+    /// settings of every opened program
+    struct Config {
+        std::string snapshotIn;
+        std::string snapshotOut;
+        ResultCache *resultCache = NULL;
+        std::string ptaKind;
+        unsigned int demandBudget = 0;
+        unsigned int workers = 0;
+        unsigned int workerTimeout = 0;
+        unsigned int workerMemory = 0;
+        bool lean = false;
+        unsigned int queryCacheMemory = 64;
+    };
+
+private:
+    Config config;
+    std::map<std::string, std::shared_ptr<Program>> programs;
+    std::weak_ptr<Program> resident;
+    /// also taken by the deleter of a program, which may run while it is held
+    std::recursive_mutex lock;
+    std::thread builder;
+    std::atomic<bool> building;
+
+public:
+    ProgramRegistry(const Config &config);
+    ~ProgramRegistry();
+
+    /// Add the program name built from modules. Fails if the name is taken
+    /// or a module does not exist.
+    bool open(const std::string &name, const std::vector<std::string> &modules, llvm::raw_ostream &out);
+    /// Remove the program name, sessions which use it keep it until they
+    /// switch to another one
+    bool close(const std::string &name, llvm::raw_ostream &out);
+    /// program name or NULL
+    std::shared_ptr<Program> get(const std::string &name);
+    /// list the programs, current is marked
+    void print(llvm::raw_ostream &out, const Program *current);
+
+    /// Make program the resident one, evicting the current one once its
+    /// runs finished. The registry lock is not held while waiting for them,
+    /// the returned lock keeps program resident.
+    std::unique_lock<std::recursive_mutex> activate(const std::shared_ptr<Program> &program);
+    /// Make program resident, build artifacts and lock its graphs for a
+    /// run. The graph lock is taken without holding the registry lock, and
+    /// exclusively while a build changes graphs runs may read.
+    std::shared_lock<std::shared_mutex> acquire(const std::shared_ptr<Program> &program,
+                                                unsigned int artifacts = 0);
+    /// same, exclusively, e.g. to reload program or select its analysis
+    std::unique_lock<std::shared_mutex> acquireExclusive(const std::shared_ptr<Program> &program);
+
+    /// Build the ICFG, the pointer analysis and the SVFG of program on a
+    /// background thread, each is published as soon as it is built. Stops
+    /// early if another program becomes resident meanwhile.
+    void prebuild(const std::shared_ptr<Program> &program);
+    /// true while the background build runs, it cannot be interrupted
+    bool isBuilding() const {
+        return building;
+    }
+};
+
+#endif // PROGRAMREGISTRY_H
@@ -0,0 +1,229 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResultCache.h"
+#include "Hash.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using namespace llvm;
+using namespace std;
+
+ResultCache::ResultCache(size_t maxMemoryMB, const string &dir, size_t maxDiskMB)
+    : memorySize(0), maxMemorySize(maxMemoryMB << 20), dir(dir), maxDiskSize(maxDiskMB << 20),
+      memoryHits(0), diskHits(0), misses(0)
+{
+    if (!dir.empty()) {
+        error_code ec;
+        fs::create_directories(dir, ec);
+        if (ec) {
+            errs() << "Error: could not create result cache " << dir << ": " << ec.message() << "\n";
+            this->dir.clear();
+        }
+    }
+}
+
+ResultCache::Result ResultCache::get(const string &key)
+{
+    lock_guard<mutex> guard(lock);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        lru.splice(lru.begin(), lru, it->second.lru);
+        memoryHits++;
+        return it->second.result;
+    }
+    Result result = load(key);
+    if (result) {
+        insert(key, result);
+        diskHits++;
+        return result;
+    }
+    misses++;
+    return Result();
+}
+
+void ResultCache::put(const string &key, const Result &result)
+{
+    lock_guard<mutex> guard(lock);
+    if (entries.count(key) == 0) {
+        insert(key, result);
+        store(key, result);
+    }
+}
+
+void ResultCache::insert(const string &key, const Result &result)
+{
+    size_t size = result->getSize() + key.size();
+    if (size > maxMemorySize) {
+        return;
+    }
+    while (memorySize + size > maxMemorySize) {
+        auto it = entries.find(lru.back());
+        memorySize -= it->second.size;
+        entries.erase(it);
+        lru.pop_back();
+    }
+    lru.push_front(key);
+    Entry &entry = entries[key];
+    entry.result = result;
+    entry.size = size;
+    entry.lru = lru.begin();
+    memorySize += size;
+}
+
+void ResultCache::invalidate()
+{
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+    lru.clear();
+    memorySize = 0;
+    if (dir.empty()) {
+        return;
+    }
+    error_code ec;
+    for (auto &file : fs::directory_iterator(dir, ec)) {
+        if (file.path().extension() == ".result") {
+            fs::remove(file.path(), ec);
+        }
+    }
+}
+
+string ResultCache::getPath(const string &key) const
+{
+    return (fs::path(dir) / (Hash::toHex(Hash::hashString(key)) + ".result")).string();
+}
+
+/// A result file starts with the version and the full key, as different
+/// keys may hash to the same file name
+ResultCache::Result ResultCache::load(const string &key)
+{
+    if (dir.empty()) {
+        return Result();
+    }
+    string path = getPath(key);
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        return Result();
+    }
+    string magic, fileKey;
+    unsigned int fileVersion = 0;
+    file >> magic >> fileVersion;
+    file.ignore(1);
+    getline(file, fileKey);
+    if (magic != "svf-server-result" || fileVersion != version || fileKey != key) {
+        return Result();
+    }
+    shared_ptr<BufferedSink> result(new BufferedSink);
+    if (!result->read(file)) {
+        return Result();
+    }
+    // the modification time orders the files for eviction
+    error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return result;
+}
+
+void ResultCache::store(const string &key, const Result &result)
+{
+    if (dir.empty()) {
+        return;
+    }
+    // written to a temporary file first, so readers never see a partial result
+    string path = getPath(key);
+    string tmpPath = path + ".tmp";
+    {
+        error_code ec;
+        raw_fd_ostream file(tmpPath, ec);
+        if (ec) {
+            return;
+        }
+        file << "svf-server-result " << version << "\n" << key << "\n";
+        result->write(file);
+    }
+    error_code ec;
+    fs::rename(tmpPath, path, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        return;
+    }
+    trimDisk();
+}
+
+void ResultCache::trimDisk()
+{
+    struct File {
+        fs::path path;
+        fs::file_time_type time;
+        uintmax_t size;
+    };
+    vector<File> files;
+    uintmax_t total = 0;
+    error_code ec;
+    for (auto &file : fs::directory_iterator(dir, ec)) {
+        if (file.path().extension() != ".result") {
+            continue;
+        }
+        File f;
+        f.path = file.path();
+        f.time = file.last_write_time(ec);
+        f.size = file.file_size(ec);
+        if (!ec) {
+            files.push_back(f);
+            total += f.size;
+        }
+    }
+    if (total <= maxDiskSize) {
+        return;
+    }
+    sort(files.begin(), files.end(), [](const File &a, const File &b) {
+        return a.time < b.time;
+    });
+    for (auto &f : files) {
+        if (total <= maxDiskSize) {
+            break;
+        }
+        if (fs::remove(f.path, ec)) {
+            total -= f.size;
+        }
+    }
+}
+
+void ResultCache::printStats(raw_ostream &os)
+{
+    lock_guard<mutex> guard(lock);
+    os << "results in memory: " << entries.size() << " (" << (memorySize >> 10) << " KB of "
+       << (maxMemorySize >> 20) << " MB)\n";
+    if (!dir.empty()) {
+        unsigned int files = 0;
+        uintmax_t total = 0;
+        error_code ec;
+        for (auto &file : fs::directory_iterator(dir, ec)) {
+            if (file.path().extension() == ".result") {
+                files++;
+                total += file.file_size(ec);
+            }
+        }
+        os << "results on disk: " << files << " (" << (total >> 10) << " KB of "
+           << (maxDiskSize >> 20) << " MB) in " << dir << "\n";
+    }
+    os << "hits: " << memoryHits + diskHits << " (memory " << memoryHits << ", disk " << diskHits
+       << ") misses: " << misses << "\n";
+}
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include "ResultSink.h"
+#include "llvm/Support/raw_ostream.h"
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/// Results of successful runs, keyed by plugin, command, arguments and
+/// analyzed program. Results are kept in memory in least recently used
+/// order and optionally stored in a directory, so they survive a restart.
+/// Both are bounded in size. All methods are thread-safe.
+class ResultCache
+{
+public:
+    typedef std::shared_ptr<const BufferedSink> Result;
+
+private:
+    static const unsigned int version = 1;
+
+    struct Entry {
+        Result result;
+        size_t size;
+        std::list<std::string>::iterator lru;
+    };
+    std::map<std::string, Entry> entries;
+    /// most recently used first
+    std::list<std::string> lru;
+    size_t memorySize;
+    size_t maxMemorySize;
+    std::string dir;
+    size_t maxDiskSize;
+
+    unsigned int memoryHits;
+    unsigned int diskHits;
+    unsigned int misses;
+    std::mutex lock;
+
+    void insert(const std::string &key, const Result &result);
+    std::string getPath(const std::string &key) const;
+    Result load(const std::string &key);
+    void store(const std::string &key, const Result &result);
+    /// remove the least recently used files until the directory fits
+    void trimDisk();
+
+public:
+    /// sizes in MB, an empty dir disables the disk cache
+    ResultCache(size_t maxMemoryMB, const std::string &dir, size_t maxDiskMB);
+
+    /// cached result or NULL
+    Result get(const std::string &key);
+    void put(const std::string &key, const Result &result);
+    /// drop all results from memory and disk
+    void invalidate();
+
+    void printStats(llvm::raw_ostream &os);
+};
+
+#endif // RESULTCACHE_H
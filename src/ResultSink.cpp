@@ -0,0 +1,220 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResultSink.h"
+#include "llvm/Support/Format.h"
+
+using namespace llvm;
+using namespace std;
+
+StreamSink::StreamSink(raw_ostream &os, Format format) : os(os), outputFormat(format), textStream(textBuffer)
+{
+}
+
+void StreamSink::writeJSONString(raw_ostream &os, const string &str)
+{
+    os << '"';
+    for (unsigned char c : str) {
+        switch (c) {
+        case '"':
+            os << "\\\"";
+            break;
+        case '\\':
+            os << "\\\\";
+            break;
+        case '\n':
+            os << "\\n";
+            break;
+        case '\t':
+            os << "\\t";
+            break;
+        default:
+            if (c < 0x20) {
+                os << format("\\u%04x", c);
+            } else {
+                os << c;
+            }
+        }
+    }
+    os << '"';
+}
+
+void StreamSink::emit(const Finding &finding)
+{
+    if (outputFormat == TEXT) {
+        os << "*";
+        if (!finding.function.empty()) {
+            os << " " << finding.function;
+        }
+        if (!finding.message.empty()) {
+            os << " " << finding.message;
+        }
+        if (!finding.location.empty()) {
+            os << " " << finding.location;
+        }
+        os << "\n";
+        return;
+    }
+    os << "{\"kind\": ";
+    writeJSONString(os, finding.kind);
+    os << ", \"function\": ";
+    writeJSONString(os, finding.function);
+    os << ", \"location\": ";
+    writeJSONString(os, finding.location);
+    os << ", \"message\": ";
+    writeJSONString(os, finding.message);
+    os << "}\n";
+}
+
+raw_ostream& StreamSink::text()
+{
+    if (outputFormat == TEXT) {
+        return os;
+    }
+    return textStream;
+}
+
+void StreamSink::finish()
+{
+    textStream.flush();
+    size_t start = 0;
+    while (start < textBuffer.size()) {
+        size_t end = textBuffer.find('\n', start);
+        if (end == string::npos) {
+            end = textBuffer.size();
+        }
+        Finding line;
+        line.kind = "text";
+        line.message = textBuffer.substr(start, end - start);
+        emit(line);
+        start = end + 1;
+    }
+    textBuffer.clear();
+}
+
+BufferedSink::BufferedSink() : textStream(textBuffer)
+{
+}
+
+void BufferedSink::flushText()
+{
+    textStream.flush();
+    if (textBuffer.empty()) {
+        return;
+    }
+    Entry entry;
+    entry.isText = true;
+    entry.finding.message = textBuffer;
+    entries.push_back(entry);
+    textBuffer.clear();
+}
+
+void BufferedSink::emit(const Finding &finding)
+{
+    flushText();
+    Entry entry;
+    entry.isText = false;
+    entry.finding = finding;
+    entries.push_back(entry);
+}
+
+raw_ostream& BufferedSink::text()
+{
+    return textStream;
+}
+
+void BufferedSink::finish()
+{
+    flushText();
+}
+
+void BufferedSink::replay(ResultSink &sink) const
+{
+    for (auto &entry : entries) {
+        if (entry.isText) {
+            sink.text() << entry.finding.message;
+        } else {
+            sink.emit(entry.finding);
+        }
+    }
+}
+
+size_t BufferedSink::getSize() const
+{
+    size_t size = sizeof(*this);
+    for (auto &entry : entries) {
+        size += sizeof(entry) + entry.finding.kind.size() + entry.finding.function.size() +
+                entry.finding.location.size() + entry.finding.message.size();
+    }
+    return size;
+}
+
+/// strings are stored as <length>:<bytes>
+static void writeString(raw_ostream &os, const string &str)
+{
+    os << str.size() << ':' << str;
+}
+
+static bool readString(istream &is, string &str)
+{
+    size_t size;
+    char colon;
+    if (!(is >> size) || !is.get(colon) || colon != ':') {
+        return false;
+    }
+    str.resize(size);
+    return size == 0 || is.read(&str[0], size);
+}
+
+void BufferedSink::write(raw_ostream &os) const
+{
+    for (auto &entry : entries) {
+        if (entry.isText) {
+            os << 'T';
+            writeString(os, entry.finding.message);
+        } else {
+            os << 'F';
+            writeString(os, entry.finding.kind);
+            writeString(os, entry.finding.function);
+            writeString(os, entry.finding.location);
+            writeString(os, entry.finding.message);
+        }
+    }
+}
+
+bool BufferedSink::read(istream &is)
+{
+    char type;
+    while (is.get(type)) {
+        Entry entry;
+        entry.isText = type == 'T';
+        if (entry.isText) {
+            if (!readString(is, entry.finding.message)) {
+                return false;
+            }
+        } else if (type == 'F') {
+            if (!readString(is, entry.finding.kind) || !readString(is, entry.finding.function) ||
+                !readString(is, entry.finding.location) || !readString(is, entry.finding.message)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        entries.push_back(entry);
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESULTSINK_H
+#define RESULTSINK_H
+
+#include "svf-plugin.h"
+#include <istream>
+#include <string>
+#include <vector>
+
+/// Renders the output of a run to a stream, either as text
+/// ("* <function> <message> <location>") or as one JSON object per line.
+/// In JSONL mode free text is emitted as findings of kind "text" when the
+/// run is finished.
+class StreamSink : public ResultSink
+{
+public:
+    enum Format {
+        TEXT,
+        JSONL,
+    };
+
+private:
+    llvm::raw_ostream &os;
+    Format outputFormat;
+    std::string textBuffer;
+    llvm::raw_string_ostream textStream;
+
+public:
+    StreamSink(llvm::raw_ostream &os, Format format);
+
+    void emit(const Finding &finding);
+    llvm::raw_ostream& text();
+    /// write the pending free text, must be called at the end of the run
+    void finish();
+
+    static void writeJSONString(llvm::raw_ostream &os, const std::string &str);
+};
+
+/// Collects the output of a run or of one shard of a parallel traversal, so
+/// it can be replayed into another sink in order, cached and stored on disk
+class BufferedSink : public ResultSink
+{
+private:
+    struct Entry {
+        bool isText;
+        Finding finding;
+    };
+    std::vector<Entry> entries;
+    std::string textBuffer;
+    llvm::raw_string_ostream textStream;
+
+    void flushText();
+
+public:
+    BufferedSink();
+
+    void emit(const Finding &finding);
+    llvm::raw_ostream& text();
+    /// end of output, must be called before the sink is replayed or written
+    void finish();
+    void replay(ResultSink &sink) const;
+    /// approximate memory size in bytes
+    size_t getSize() const;
+
+    void write(llvm::raw_ostream &os) const;
+    bool read(std::istream &is);
+};
+
+#endif // RESULTSINK_H
@@ -0,0 +1,71 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SVFOptions.h"
+#include "Hash.h"
+#include "llvm/Support/CommandLine.h"
+#include <algorithm>
+
+using namespace llvm;
+using namespace std;
+
+string SVFOptions::hash = Hash::toHex(Hash::offset);
+mutex SVFOptions::lock;
+
+bool SVFOptions::set(const string &name, const string &value)
+{
+    auto &registered = cl::getRegisteredOptions();
+    auto it = registered.find(name);
+    if (it == registered.end()) {
+        return false;
+    }
+    lock_guard<mutex> guard(lock);
+    // as one of several values, so the occurrence limit does not apply
+    return !it->second->addOccurrence(0, name, value, true);
+}
+
+bool SVFOptions::isGiven(const string &name)
+{
+    auto &registered = cl::getRegisteredOptions();
+    auto it = registered.find(name);
+    lock_guard<mutex> guard(lock);
+    return it != registered.end() && it->second->getNumOccurrences() > 0;
+}
+
+void SVFOptions::setCommandLine(int argc, char **argv, const cl::OptionCategory &ignored)
+{
+    auto &registered = cl::getRegisteredOptions();
+    uint64_t h = Hash::offset;
+    for (int i = 1; i < argc; i++) {
+        StringRef arg(argv[i]);
+        auto it = registered.find(arg.ltrim('-').split('=').first);
+        if (it != registered.end()) {
+            auto &categories = it->second->Categories;
+            if (find(categories.begin(), categories.end(), &ignored) != categories.end()) {
+                // the value may be the next argument
+                if (!arg.contains('=') && it->second->getValueExpectedFlag() == cl::ValueRequired) {
+                    i++;
+                }
+                continue;
+            }
+        }
+        // a separator, so -a=bc and -ab=c differ
+        h = Hash::hashString(argv[i], h);
+        h = Hash::update(h, "", 1);
+    }
+    hash = Hash::toHex(h);
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SVFOPTIONS_H
+#define SVFOPTIONS_H
+
+#include <mutex>
+#include <string>
+
+namespace llvm {
+namespace cl {
+class OptionCategory;
+}
+}
+
+/// Changes SVF's command line options after the command line was parsed.
+/// SVF reads its options from static cl::opt objects, so a value is passed
+/// through the option's own parser as if it was given as -name=value.
+/// SVF reads the options without synchronization, an option must not be
+/// changed while a build or query may read it. The snapshot options are
+/// only set by the resident program under its build lock, -cxtbg only
+/// under the query lock of DemandPTA.
+class SVFOptions
+{
+public:
+    /// Set the option name to value. It is not counted as an occurrence,
+    /// so it can be set again and isGiven does not change. Returns false if
+    /// there is no such option or value is invalid for it. Changes are
+    /// serialized with each other.
+    static bool set(const std::string &name, const std::string &value);
+    /// true if the option name was given on the command line
+    static bool isGiven(const std::string &name);
+
+    /// Remember the parsed options, argv without the program name and the
+    /// input modules. Options of category ignored are left out.
+    static void setCommandLine(int argc, char **argv, const llvm::cl::OptionCategory &ignored);
+    /// hash of the options given on the command line, results and
+    /// snapshots of different options must not be mixed up
+    static const std::string& getHash() {
+        return hash;
+    }
+
+private:
+    static std::string hash;
+    static std::mutex lock;
+};
+
+#endif // SVFOPTIONS_H
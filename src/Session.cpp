@@ -0,0 +1,403 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Session.h"
+#include "Hash.h"
+#include "Util/SVFUtil.h"
+#include "llvm/Support/FileSystem.h"
+#include <dlfcn.h>
+#include <boost/algorithm/string/join.hpp>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+Session::Session(ProgramRegistry *registry) : registry(registry), program(registry->get("default")),
+    lib(NULL), plugin(NULL), format(StreamSink::TEXT)
+{
+}
+
+Session::~Session()
+{
+    unload();
+}
+
+void Session::unload()
+{
+    if (plugin != NULL) {
+        delete plugin;
+        plugin = NULL;
+    }
+    if (lib != NULL) {
+        dlclose(lib);
+        lib = NULL;
+    }
+    pluginHash.clear();
+}
+
+void Session::usage(raw_ostream &out) {
+    out << "Available commands:\n";
+    out << "    load <lib.so>  load library\n";
+    out << "    ls             show available functions provided by loaded library\n";
+    out << "    run <func>     run function from loaded library\n";
+    out << "    run-all [checker[=arg,...] ...]  run the given (default all) checkers in one traversal\n";
+    out << "    pts <value ...>  show the points-to sets of values, e.g. @global, func:name or file.c:12\n";
+    out << "    alias <a> <b> [<a> <b> ...]  show whether pairs of values may alias\n";
+    out << "    output <text|jsonl> [file]  write run results as text or JSON lines, to the session or a file\n";
+    out << "    stats [json [file]]  show time and memory of the graph construction phases\n";
+    out << "    status         show which graphs are ready and which are being built\n";
+    out << "    cache stats    show size and hit rate of the result and points-to query caches\n";
+    out << "    invalidate     drop all cached run results\n";
+    out << "    analysis [kind]  show or select the pointer analysis, e.g. steensgaard or fs\n";
+    out << "    reload [module ...]  rebuild the graphs if the given (default all) modules changed\n";
+    out << "    open <name> <bitcode ...>  open another program\n";
+    out << "    use [name]     show the programs or analyze program name in this session\n";
+    out << "    close <name>   close a program which is not used by this session\n";
+    out << "    help|?         show this help\n";
+    out << "    exit           stop the server\n";
+}
+
+Session::Status Session::execute(list<string> args, raw_ostream &out)
+{
+    string cmd;
+    string opt;
+    if (args.size() > 0) {
+        cmd = *args.cbegin();
+        args.pop_front();
+    }
+    if (args.size() > 0) {
+        opt = *args.cbegin();
+        args.pop_front();
+    }
+
+    if (cmd == "exit") {
+        out << "Stopping server...\n";
+        return EXIT;
+    } else if (cmd == "load") {
+        // Load dym lib
+        if (opt.empty()) {
+            out << "Error: please provide argument\n";
+            usage(out);
+            return ERROR;
+        }
+        unload();
+        lib = dlopen(opt.c_str(), RTLD_NOW);
+        if (lib == NULL) {
+            out << "Error: Coudl not load library\n";
+            return ERROR;
+        }
+        void *maker = dlsym(lib, "getPlugin");
+        if (maker == NULL) {
+            out << "Error: Could not find getPlugin function for plugin\n";
+            return ERROR;
+        }
+        svf_analyzer func = reinterpret_cast<svf_analyzer>(reinterpret_cast<void*>(maker));
+        plugin = func();
+        if (plugin == NULL) {
+            out << "Error: could not instantiate plugin object\n";
+            return ERROR;
+        }
+        plugin->init(program.get());
+        program->touch();
+        // the file dlopen mapped, opt may have been resolved via the search path
+        Dl_info info;
+        uint64_t hash = Hash::offset;
+        if (dladdr(maker, &info) != 0 && info.dli_fname != NULL && Hash::hashFile(info.dli_fname, hash)) {
+            pluginHash = Hash::toHex(hash);
+        } else {
+            out << "Error: could not read the library file, run results are not cached\n";
+        }
+        out << "library loaded\n";
+    } else if (cmd == "ls") {
+        // list help of plugin
+        if (plugin == NULL) {
+            out << "Error: No library was loaded. Please load library first\n";
+            return ERROR;
+        }
+        plugin->help(out);
+    } else if (cmd == "output") {
+        if (!opt.empty()) {
+            args.push_front(opt);
+        }
+        return setOutput(args, out);
+    } else if (cmd == "stats") {
+        if (opt.empty()) {
+            program->getStats().print(out);
+        } else if (opt == "json" && args.empty()) {
+            program->getStats().printJSON(out);
+        } else if (opt == "json") {
+            error_code ec;
+            raw_fd_ostream file(args.front(), ec);
+            if (ec) {
+                out << "Error: could not open " << args.front() << ": " << ec.message() << "\n";
+                return ERROR;
+            }
+            program->getStats().printJSON(file);
+            out << "stats written to " << args.front() << "\n";
+        } else {
+            out << "Error: Invalid argument: " << opt << "\n";
+            usage(out);
+            return ERROR;
+        }
+    } else if (cmd == "status") {
+        program->printStatus(out);
+    } else if (cmd == "cache") {
+        if (opt != "stats") {
+            out << "Error: Invalid argument: " << opt << "\n";
+            usage(out);
+            return ERROR;
+        }
+        program->getResultCache()->printStats(out);
+        program->printDemandStats(out);
+        program->printQueryStats(out);
+    } else if (cmd == "invalidate") {
+        program->getResultCache()->invalidate();
+        out << "result cache cleared\n";
+    } else if (cmd == "analysis") {
+        if (opt.empty()) {
+            program->printAnalyses(out);
+        } else {
+            auto graphs = registry->acquireExclusive(program);
+            if (!program->selectAnalysis(opt, out)) {
+                return ERROR;
+            }
+        }
+    } else if (cmd == "reload") {
+        vector<string> modules;
+        if (!opt.empty()) {
+            modules.push_back(opt);
+        }
+        modules.insert(modules.end(), args.begin(), args.end());
+        auto graphs = registry->acquireExclusive(program);
+        if (!program->reload(modules, out)) {
+            return ERROR;
+        }
+    } else if (cmd == "open") {
+        if (opt.empty() || args.empty()) {
+            out << "Error: please provide a name and the bitcode files\n";
+            usage(out);
+            return ERROR;
+        }
+        if (!registry->open(opt, vector<string>(args.begin(), args.end()), out)) {
+            return ERROR;
+        }
+        out << "program " << opt << " opened\n";
+    } else if (cmd == "use") {
+        if (opt.empty()) {
+            registry->print(out, program.get());
+        } else {
+            return use(opt, out);
+        }
+    } else if (cmd == "close") {
+        if (opt.empty()) {
+            out << "Error: please provide argument\n";
+            usage(out);
+            return ERROR;
+        }
+        if (registry->get(opt) == program) {
+            out << "Error: program " << opt << " is used by this session\n";
+            return ERROR;
+        }
+        if (!registry->close(opt, out)) {
+            return ERROR;
+        }
+        out << "program " << opt << " closed\n";
+    } else if (cmd == "help") {
+        usage(out);
+    } else if (cmd == "?") {
+        usage(out);
+    } else if (cmd == "run") {
+        // run function from lib
+        if (opt.empty()) {
+            out << "Error: please provide argument\n";
+            usage(out);
+            return ERROR;
+        }
+        if (plugin == NULL) {
+            out << "Error: No library was loaded. Please load library first\n";
+            return ERROR;
+        }
+        return run(opt, args, out);
+    } else if (cmd == "pts" || cmd == "alias") {
+        if (opt.empty()) {
+            out << "Error: please provide argument\n";
+            usage(out);
+            return ERROR;
+        }
+        args.push_front(opt);
+        return query(cmd, args, out);
+    } else if (cmd == "run-all") {
+        if (plugin == NULL) {
+            out << "Error: No library was loaded. Please load library first\n";
+            return ERROR;
+        }
+        if (!opt.empty()) {
+            args.push_front(opt);
+        } else {
+            vector<string> checkers = plugin->getCheckers();
+            args.assign(checkers.begin(), checkers.end());
+        }
+        if (args.empty()) {
+            out << "Error: the loaded library has no checkers\n";
+            return ERROR;
+        }
+        return runAll(args, out);
+    } else {
+        out << "Error: Invalid command: " << cmd << " " << opt << " " << boost::algorithm::join(args, " ") << "\n";
+        usage(out);
+        return ERROR;
+    }
+    return OK;
+}
+
+/// Results of successful runs are cached, keyed by the plugin content, the
+/// command, its arguments and the analyzed program. A cache hit is replayed
+/// without building any graph.
+Session::Status Session::run(const string &funcName, list<string> &args, raw_ostream &out)
+{
+    return runCached(funcName, args, false, out);
+}
+
+/// The checkers share one traversal of the graphs, their output is cached
+/// as one result.
+Session::Status Session::runAll(list<string> &checkers, raw_ostream &out)
+{
+    return runCached("run-all", checkers, true, out);
+}
+
+Session::Status Session::runCached(const string &funcName, list<string> &args, bool checkers,
+                                   raw_ostream &out)
+{
+    // the identity is read without the graph lock, a cache hit neither
+    // activates the program nor evicts another one
+    auto getKey = [&]() {
+        string key = pluginHash + " " + funcName;
+        for (auto &arg : args) {
+            key += '\x1f' + arg;
+        }
+        return key + " " + program->getIdentity();
+    };
+    // without a plugin hash the result cannot be attributed to the plugin
+    ResultCache *cache = pluginHash.empty() ? NULL : program->getResultCache();
+    ResultCache::Result cached = cache != NULL ? cache->get(getKey()) : ResultCache::Result();
+    bool ok = true;
+    if (!cached) {
+        unsigned int requirements = 0;
+        if (checkers) {
+            for (auto &spec : args) {
+                list<string> checkerArgs;
+                requirements |= plugin->getRequirements(Program::parseChecker(spec, checkerArgs));
+            }
+        } else {
+            requirements = plugin->getRequirements(funcName);
+        }
+        // the graphs must not be reloaded or evicted while the plugin uses
+        // them, the program may have been reloaded since the lookup
+        auto graphs = registry->acquire(program, requirements);
+        string key = getKey();
+        shared_ptr<BufferedSink> result(new BufferedSink);
+        WorkerPool *workers = program->getWorkerPool();
+        if (workers != NULL) {
+            ok = workers->run(plugin, funcName, args, *result, checkers) == WorkerPool::OK;
+        } else if (checkers) {
+            ok = program->runCheckers(plugin, args, *result);
+        } else {
+            ok = plugin->run(funcName, args, *result);
+        }
+        result->finish();
+        if (ok && cache != NULL) {
+            cache->put(key, result);
+        }
+        cached = result;
+    }
+
+    // results are rendered into a buffer and written in one piece, so
+    // concurrent runs do not interleave
+    string result;
+    raw_string_ostream os(result);
+    StreamSink sink(os, format);
+    cached->replay(sink);
+    sink.finish();
+    os.flush();
+    write(result, out);
+    return ok ? OK : ERROR;
+}
+
+/// Queries are answered in the server process from the cached points-to
+/// sets, they are not stored in the result cache
+Session::Status Session::query(const string &cmd, const list<string> &ids, raw_ostream &out)
+{
+    auto graphs = registry->acquire(program, PTA_ARTIFACT);
+    string result;
+    raw_string_ostream os(result);
+    bool ok = cmd == "pts" ? program->printPointsTo(ids, os) : program->printAliases(ids, os);
+    os.flush();
+    write(result, out);
+    return ok ? OK : ERROR;
+}
+
+void Session::write(const string &result, raw_ostream &out)
+{
+    lock_guard<mutex> guard(outputLock);
+    if (outputFile) {
+        *outputFile << result;
+        outputFile->flush();
+    } else {
+        out << result;
+    }
+}
+
+Session::Status Session::use(const string &name, raw_ostream &out)
+{
+    shared_ptr<Program> next = registry->get(name);
+    if (!next) {
+        out << "Error: no program " << name << "\n";
+        return ERROR;
+    }
+    program = next;
+    if (plugin != NULL) {
+        // workers forked before still see the plugin with the old program
+        plugin->init(program.get());
+        program->touch();
+    }
+    out << "using program " << name << "\n";
+    return OK;
+}
+
+Session::Status Session::setOutput(list<string> &args, raw_ostream &out)
+{
+    if (args.empty() || (args.front() != "text" && args.front() != "jsonl")) {
+        out << "Error: please provide output format text or jsonl\n";
+        usage(out);
+        return ERROR;
+    }
+    lock_guard<mutex> guard(outputLock);
+    format = args.front() == "text" ? StreamSink::TEXT : StreamSink::JSONL;
+    args.pop_front();
+    outputFile.reset();
+    if (!args.empty()) {
+        error_code ec;
+        outputFile.reset(new raw_fd_ostream(args.front(), ec, sys::fs::OF_Append));
+        if (ec) {
+            out << "Error: could not open " << args.front() << ": " << ec.message() << "\n";
+            outputFile.reset();
+            return ERROR;
+        }
+        out << "results are written to " << args.front() << "\n";
+    }
+    return OK;
+}
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include "Program.h"
+#include "ProgramRegistry.h"
+#include "svf-plugin.h"
+#include "ResultSink.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/// Command interpreter of one client. Every client has its own loaded
+/// plugin and selects one of the analyzed programs, which are shared by all
+/// sessions.
+class Session
+{
+public:
+    enum Status {
+        OK,
+        ERROR,
+        EXIT,
+    };
+
+private:
+    ProgramRegistry *registry;
+    std::shared_ptr<Program> program;
+    void *lib;
+    Plugin *plugin;
+    /// content hash of the loaded plugin, part of the result cache key
+    std::string pluginHash;
+    StreamSink::Format format;
+    std::unique_ptr<llvm::raw_fd_ostream> outputFile;
+    std::mutex outputLock;
+
+    void unload();
+    Status setOutput(std::list<std::string> &args, llvm::raw_ostream &out);
+    Status use(const std::string &name, llvm::raw_ostream &out);
+    Status run(const std::string &funcName, std::list<std::string> &args, llvm::raw_ostream &out);
+    Status runAll(std::list<std::string> &checkers, llvm::raw_ostream &out);
+    /// answer the pts or alias command for the value identifiers ids
+    Status query(const std::string &cmd, const std::list<std::string> &ids, llvm::raw_ostream &out);
+    /// write results to the output file of the session or to out
+    void write(const std::string &result, llvm::raw_ostream &out);
+    /// run funcName or, with checkers, the fused checkers args through the
+    /// result cache
+    Status runCached(const std::string &funcName, std::list<std::string> &args, bool checkers,
+                     llvm::raw_ostream &out);
+
+public:
+    /// starts with the program "default"
+    Session(ProgramRegistry *registry);
+    ~Session();
+
+    /// Execute one command line, all output is written to out. Several run
+    /// commands may execute concurrently, load must not run concurrently to
+    /// any other command of the same session.
+    Status execute(std::list<std::string> args, llvm::raw_ostream &out);
+
+    static void usage(llvm::raw_ostream &out);
+};
+
+#endif // SESSION_H
@@ -0,0 +1,161 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Snapshot.h"
+#include "Hash.h"
+#include "SVFOptions.h"
+#include "Util/SVFUtil.h"
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+static const char *artifacts[] = {"ander", "svfg"};
+
+Snapshot::Snapshot(const string &inBaseDir, const string &outBaseDir,
+                   const vector<string> &moduleNameVec, const string &ptaKind)
+    : inBaseDir(inBaseDir), outBaseDir(outBaseDir)
+{
+    setKey(moduleNameVec, ptaKind);
+}
+
+// SVF's serializers do not record the options, results of other options
+// would be read without an error
+void Snapshot::setKey(const vector<string> &moduleNameVec, const string &ptaKind)
+{
+    uint64_t hash = Hash::hashFiles(moduleNameVec);
+    hash = Hash::hashString(ptaKind, hash);
+    hash = Hash::hashString(SVFOptions::getHash(), hash);
+    unsigned int v = version;
+    key = Hash::toHex(Hash::update(hash, &v, sizeof(v)));
+    inDir.clear();
+    outDir.clear();
+    if (!inBaseDir.empty()) {
+        inDir = (fs::path(inBaseDir) / key).string();
+    }
+    if (!outBaseDir.empty()) {
+        outDir = (fs::path(outBaseDir) / key).string();
+    }
+}
+
+bool Snapshot::has(const string &dir, const string &artifact) const
+{
+    ifstream manifest(fs::path(dir) / "manifest");
+    if (!manifest.is_open()) {
+        return false;
+    }
+    string magic, manifestKey;
+    unsigned int manifestVersion = 0;
+    manifest >> magic >> manifestVersion >> manifestKey;
+    if (magic != "svf-server-snapshot" || manifestVersion != version || manifestKey != key) {
+        return false;
+    }
+    string name;
+    while (manifest >> name) {
+        if (name == artifact) {
+            error_code ec;
+            return fs::exists(fs::path(dir) / artifact, ec);
+        }
+    }
+    return false;
+}
+
+bool Snapshot::prepare() const
+{
+    error_code ec;
+    fs::create_directories(outDir, ec);
+    if (ec) {
+        return false;
+    }
+    ifstream current(fs::path(outDir) / "manifest");
+    string magic, manifestKey;
+    unsigned int manifestVersion = 0;
+    current >> magic >> manifestVersion >> manifestKey;
+    if (magic == "svf-server-snapshot" && manifestVersion == version && manifestKey == key) {
+        return true;
+    }
+    ofstream manifest(fs::path(outDir) / "manifest", ios::trunc);
+    manifest << "svf-server-snapshot " << version << " " << key << "\n";
+    return manifest.good();
+}
+
+const vector<pair<string, string>>& Snapshot::selectOptions()
+{
+    options.clear();
+    bool writable = !outDir.empty() && prepare();
+    if (!outDir.empty() && !writable) {
+        SVFUtil::outs() << "Error: could not create snapshot directory " << outDir << "\n";
+    }
+    for (string artifact : artifacts) {
+        if (!inDir.empty() && has(inDir, artifact)) {
+            SVFUtil::outs() << "restore " << artifact << " from snapshot " << inDir << "\n";
+            options.push_back(make_pair("read-" + artifact, (fs::path(inDir) / artifact).string()));
+        } else if (!outDir.empty() && has(outDir, artifact)) {
+            // written before this program was evicted
+            SVFUtil::outs() << "restore " << artifact << " from snapshot " << outDir << "\n";
+            options.push_back(make_pair("read-" + artifact, (fs::path(outDir) / artifact).string()));
+        } else if (writable) {
+            options.push_back(make_pair("write-" + artifact, (fs::path(outDir) / artifact).string()));
+            pending.insert(artifact);
+        }
+    }
+    return options;
+}
+
+void Snapshot::update(const vector<string> &moduleNameVec, const string &ptaKind)
+{
+    setKey(moduleNameVec, ptaKind);
+    apply();
+}
+
+void Snapshot::apply()
+{
+    pending.clear();
+    selectOptions();
+    setEnabled(true);
+}
+
+void Snapshot::setEnabled(bool enabled)
+{
+    for (string artifact : artifacts) {
+        SVFOptions::set("read-" + artifact, "");
+        SVFOptions::set("write-" + artifact, "");
+    }
+    if (enabled) {
+        for (auto &option : options) {
+            SVFOptions::set(option.first, option.second);
+        }
+    }
+}
+
+void Snapshot::commit(const string &artifact)
+{
+    if (pending.erase(artifact) == 0) {
+        return;
+    }
+    ofstream manifest(fs::path(outDir) / "manifest", ios::app);
+    manifest << artifact << "\n";
+    if (manifest.good()) {
+        SVFUtil::outs() << "snapshot " << artifact << " written to " << outDir << "\n";
+    } else {
+        SVFUtil::outs() << "Error: could not write snapshot " << outDir << "\n";
+    }
+}
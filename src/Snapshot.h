@@ -0,0 +1,81 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// On-disk image of the expensive analysis results of one program.
+///
+/// A snapshot lives in <dir>/<key>/ where key is a hash over the content of
+/// all input bitcode files, the pointer analysis kind, the command line
+/// options and the snapshot format version. The points-to
+/// results and the SVFG are written and read by SVF's own serializers
+/// (-write-ander/-read-ander, -write-svfg/-read-svfg), the SVFIR and ICFG
+/// are rebuilt from the bitcode, which is deterministic for the same input.
+/// Every artifact is committed to the manifest once it is completely
+/// written, so artifacts which were never built are simply missing.
+class Snapshot
+{
+private:
+    std::string inBaseDir;
+    std::string outBaseDir;
+    std::string key;
+    std::string inDir;
+    std::string outDir;
+    std::set<std::string> pending;
+    /// SVF options selected for the current key
+    std::vector<std::pair<std::string, std::string>> options;
+
+    void setKey(const std::vector<std::string> &moduleNameVec, const std::string &ptaKind);
+    bool has(const std::string &dir, const std::string &artifact) const;
+    bool prepare() const;
+    /// SVF option names and values for the current key
+    const std::vector<std::pair<std::string, std::string>>& selectOptions();
+
+public:
+    static const unsigned int version = 1;
+
+    Snapshot(const std::string &inBaseDir, const std::string &outBaseDir,
+             const std::vector<std::string> &moduleNameVec, const std::string &ptaKind);
+
+    const std::string &getKey() const {
+        return key;
+    }
+
+    /// Select SVF options which read all artifacts available in the input
+    /// or output snapshot and write the missing ones to the output snapshot,
+    /// and apply them. The options are process-wide, they are applied again
+    /// whenever the program of the snapshot is about to be built. Only the
+    /// resident program changes them, under its build lock.
+    void apply();
+    /// switch to the snapshot of changed input bitcode or another pointer
+    /// analysis, the SVF options are updated in place as the command line
+    /// is parsed only once
+    void update(const std::vector<std::string> &moduleNameVec, const std::string &ptaKind);
+    /// disable the SVF options while analyses are built whose results must
+    /// not be read from or written to the snapshot
+    void setEnabled(bool enabled);
+    /// mark artifact (ander, svfg) as completely written
+    void commit(const std::string &artifact);
+};
+
+#endif // SNAPSHOT_H
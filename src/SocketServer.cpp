@@ -0,0 +1,303 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SocketServer.h"
+#include "Session.h"
+#include "Util/SVFUtil.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+/// server stopped by SIGINT and SIGTERM
+static SocketServer *signalTarget = NULL;
+
+static void stopOnSignal(int)
+{
+    if (signalTarget != NULL) {
+        signalTarget->stop();
+    }
+}
+
+static bool writeAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+}
+
+SocketServer::SocketServer(ProgramRegistry *registry) : registry(registry), unixFd(-1), tcpFd(-1)
+{
+    if (pipe2(wakeFds, O_CLOEXEC | O_NONBLOCK) < 0) {
+        wakeFds[0] = wakeFds[1] = -1;
+    }
+}
+
+SocketServer::~SocketServer()
+{
+    if (wakeFds[0] >= 0) {
+        close(wakeFds[0]);
+        close(wakeFds[1]);
+    }
+    if (unixFd >= 0) {
+        close(unixFd);
+        unlink(socketPath.c_str());
+    }
+    if (tcpFd >= 0) {
+        close(tcpFd);
+    }
+}
+
+bool SocketServer::listenUnix(const string &path)
+{
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        SVFUtil::outs() << "Error: socket path too long: " << path << "\n";
+        return false;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    unixFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (unixFd < 0) {
+        SVFUtil::outs() << "Error: could not create socket: " << strerror(errno) << "\n";
+        return false;
+    }
+    // remove a stale socket of a previous server
+    unlink(path.c_str());
+    if (bind(unixFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(unixFd, 64) < 0) {
+        SVFUtil::outs() << "Error: could not listen on " << path << ": " << strerror(errno) << "\n";
+        close(unixFd);
+        unixFd = -1;
+        return false;
+    }
+    socketPath = path;
+    SVFUtil::outs() << "listening on " << path << "\n";
+    return true;
+}
+
+bool SocketServer::listenTCP(unsigned short port)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    tcpFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (tcpFd < 0) {
+        SVFUtil::outs() << "Error: could not create socket: " << strerror(errno) << "\n";
+        return false;
+    }
+    int one = 1;
+    setsockopt(tcpFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(tcpFd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(tcpFd, 64) < 0) {
+        SVFUtil::outs() << "Error: could not listen on localhost:" << port << ": " << strerror(errno) << "\n";
+        close(tcpFd);
+        tcpFd = -1;
+        return false;
+    }
+    SVFUtil::outs() << "listening on localhost:" << port << "\n";
+    return true;
+}
+
+void SocketServer::stop()
+{
+    if (wakeFds[1] >= 0) {
+        ssize_t ignored = write(wakeFds[1], "x", 1);
+        (void)ignored;
+    }
+}
+
+void SocketServer::run()
+{
+    signal(SIGPIPE, SIG_IGN);
+    signalTarget = this;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopOnSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    bool stopped = false;
+    while (!stopped) {
+        struct pollfd fds[3];
+        nfds_t n = 0;
+        if (unixFd >= 0) {
+            fds[n].fd = unixFd;
+            fds[n].events = POLLIN;
+            n++;
+        }
+        if (tcpFd >= 0) {
+            fds[n].fd = tcpFd;
+            fds[n].events = POLLIN;
+            n++;
+        }
+        if (n == 0) {
+            break;
+        }
+        fds[n].fd = wakeFds[0];
+        fds[n].events = POLLIN;
+        if (poll(fds, n + 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            SVFUtil::outs() << "Error: poll failed: " << strerror(errno) << "\n";
+            break;
+        }
+        if (fds[n].revents & POLLIN) {
+            stopped = true;
+            break;
+        }
+        for (nfds_t i = 0; i < n; i++) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            int fd = accept4(fds[i].fd, NULL, NULL, SOCK_CLOEXEC);
+            if (fd < 0) {
+                continue;
+            }
+            lock_guard<mutex> guard(clientsLock);
+            clients.insert(fd);
+            thread(&SocketServer::serve, this, fd).detach();
+        }
+    }
+
+    // no new requests are read, the sessions finish their runs and close
+    SVFUtil::outs() << "shutting down\n";
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signalTarget = NULL;
+    unique_lock<mutex> guard(clientsLock);
+    for (int fd : clients) {
+        shutdown(fd, SHUT_RD);
+    }
+    finished.wait(guard, [&]() { return clients.empty(); });
+}
+
+void SocketServer::serve(int fd)
+{
+    Session session(registry);
+    mutex lock;
+    condition_variable idle;
+    unsigned int running = 0;
+
+    auto respond = [&](const string &id, Session::Status status, const string &output) {
+        string header = id + (status == Session::ERROR ? " error " : " ok ") + to_string(output.size()) + "\n";
+        lock_guard<mutex> guard(lock);
+        writeAll(fd, header.data(), header.size());
+        writeAll(fd, output.data(), output.size());
+    };
+    auto waitIdle = [&]() {
+        unique_lock<mutex> guard(lock);
+        idle.wait(guard, [&]() { return running == 0; });
+    };
+
+    string buffer;
+    char chunk[4096];
+    bool done = false;
+    while (!done) {
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        buffer.append(chunk, n);
+        if (buffer.find('\n') == string::npos && buffer.size() > maxLineLength) {
+            respond("-", Session::ERROR, "Error: request too long\n");
+            break;
+        }
+        size_t eol;
+        while (!done && (eol = buffer.find('\n')) != string::npos) {
+            string line = buffer.substr(0, eol);
+            buffer.erase(0, eol + 1);
+            boost::algorithm::trim(line);
+            if (line.empty()) {
+                continue;
+            }
+            list<string> args;
+            boost::split(args, line, boost::is_any_of(" "), boost::token_compress_on);
+            string id = args.front();
+            args.pop_front();
+
+            if (!args.empty() && args.front() == "run") {
+                {
+                    lock_guard<mutex> guard(lock);
+                    running++;
+                }
+                thread([&, id, args]() {
+                    string output;
+                    raw_string_ostream os(output);
+                    Session::Status status = session.execute(args, os);
+                    os.flush();
+                    respond(id, status, output);
+                    lock_guard<mutex> guard(lock);
+                    running--;
+                    idle.notify_all();
+                }).detach();
+                continue;
+            }
+
+            // commands other than run may change the session state
+            waitIdle();
+            if (!args.empty() && args.front() == "shutdown") {
+                respond(id, Session::OK, "server shutting down\n");
+                stop();
+                done = true;
+                break;
+            }
+            string output;
+            raw_string_ostream os(output);
+            Session::Status status = session.execute(args, os);
+            os.flush();
+            respond(id, status, output);
+            done = status == Session::EXIT;
+        }
+    }
+    waitIdle();
+    lock_guard<mutex> guard(clientsLock);
+    close(fd);
+    clients.erase(fd);
+    finished.notify_all();
+}
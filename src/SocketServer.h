@@ -0,0 +1,71 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOCKETSERVER_H
+#define SOCKETSERVER_H
+
+#include "ProgramRegistry.h"
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+
+/// Serves sessions to clients connected via a Unix domain socket or TCP on
+/// localhost.
+///
+/// Protocol: every request is one line "<id> <command> [args...]", the id
+/// is chosen by the client. Every response is a header line
+/// "<id> <ok|error> <length>" followed by length bytes of command output.
+/// Requests may be pipelined. run requests of one connection execute
+/// concurrently and respond in completion order, all other commands wait
+/// for the runs in flight and execute in request order. exit closes the
+/// connection, shutdown stops the server like SIGINT or SIGTERM. A request
+/// longer than maxLineLength closes the connection.
+class SocketServer
+{
+private:
+    ProgramRegistry *registry;
+    int unixFd;
+    int tcpFd;
+    std::string socketPath;
+    /// written to wake up run() for a shutdown
+    int wakeFds[2];
+    std::mutex clientsLock;
+    std::condition_variable finished;
+    /// connections being served
+    std::set<int> clients;
+
+    void serve(int fd);
+
+public:
+    SocketServer(ProgramRegistry *registry);
+    ~SocketServer();
+
+    bool listenUnix(const std::string &path);
+    bool listenTCP(unsigned short port);
+
+    static const size_t maxLineLength = 1 << 20;
+
+    /// Accept clients until shutdown, SIGINT or SIGTERM. Returns once the
+    /// runs in flight are finished and all connections are closed.
+    void run();
+    /// make run() return, async-signal-safe
+    void stop();
+};
+
+#endif // SOCKETSERVER_H
@@ -0,0 +1,140 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+
+using namespace std;
+
+namespace {
+
+/// one parallelFor call, guarded by the pool lock
+struct Loop {
+    size_t count;
+    const function<void(size_t)> *func;
+    /// next index to claim
+    size_t next;
+    /// claimed indices whose call did not finish yet
+    size_t running;
+};
+
+/// State shared by the workers and the callers. It is never destroyed: the
+/// detached workers wait on it until the process exits.
+struct Pool {
+    mutex lock;
+    /// workers wait for loops
+    condition_variable wake;
+    /// callers wait for the calls of their loop the workers run
+    condition_variable finished;
+    /// loops with indices left to claim, oldest first
+    deque<Loop*> loops;
+    unsigned int started = 0;
+};
+
+}
+
+static Pool *pool = new Pool;
+
+unsigned int ThreadPool::numThreads = 0;
+
+/// claim the next index of loop and drop it from the queue once all are
+/// claimed, the lock is held
+static size_t claim(Loop *loop)
+{
+    size_t i = loop->next++;
+    if (loop->next == loop->count) {
+        pool->loops.erase(find(pool->loops.begin(), pool->loops.end(), loop));
+    }
+    loop->running++;
+    return i;
+}
+
+/// call index i of loop without the lock
+static void call(Loop *loop, size_t i, unique_lock<mutex> &guard)
+{
+    guard.unlock();
+    (*loop->func)(i);
+    guard.lock();
+    // the caller may return and free the loop once it was notified
+    if (--loop->running == 0 && loop->next == loop->count) {
+        pool->finished.notify_all();
+    }
+}
+
+static void work()
+{
+    unique_lock<mutex> guard(pool->lock);
+    while (true) {
+        pool->wake.wait(guard, []() { return !pool->loops.empty(); });
+        Loop *loop = pool->loops.front();
+        call(loop, claim(loop), guard);
+    }
+}
+
+// the workers do not exist in a forked child, and the lock may have been
+// held by one of them
+static void resetAfterFork()
+{
+    pool = new Pool;
+}
+
+void ThreadPool::setNumThreads(unsigned int threads)
+{
+    numThreads = threads;
+}
+
+unsigned int ThreadPool::getNumThreads()
+{
+    if (numThreads > 0) {
+        return numThreads;
+    }
+    unsigned int cores = thread::hardware_concurrency();
+    return cores > 0 ? cores : 1;
+}
+
+void ThreadPool::parallelFor(size_t count, const function<void(size_t)> &func)
+{
+    unsigned int threads = getNumThreads();
+    if (threads <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            func(i);
+        }
+        return;
+    }
+
+    Loop loop = {count, &func, 0, 0};
+    unique_lock<mutex> guard(pool->lock);
+    if (pool->started == 0) {
+        static once_flag registered;
+        call_once(registered, []() { pthread_atfork(NULL, NULL, resetAfterFork); });
+    }
+    // the calling thread is the last one
+    for (; pool->started < threads - 1; pool->started++) {
+        thread(work).detach();
+    }
+    pool->loops.push_back(&loop);
+    pool->wake.notify_all();
+    while (loop.next < loop.count) {
+        call(&loop, claim(&loop), guard);
+    }
+    pool->finished.wait(guard, [&]() { return loop.running == 0; });
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <cstddef>
+#include <functional>
+
+/// Parallel loops over the read-only graphs.
+///
+/// The worker threads are started on first use and shared by all callers,
+/// so concurrent loops, e.g. runs of several clients, do not start threads
+/// of their own. Every loop is put into one queue; idle workers claim the
+/// next index of the oldest loop, and the calling thread works on its own
+/// loop until all of its indices are claimed and finished. A forked child
+/// starts new workers on its first loop.
+class ThreadPool
+{
+private:
+    static unsigned int numThreads;
+
+public:
+    /// number of threads to use, 0 selects one thread per core
+    static void setNumThreads(unsigned int threads);
+    static unsigned int getNumThreads();
+
+    /// call func(i) for every i in [0, count), returns once all calls
+    /// finished
+    static void parallelFor(size_t count, const std::function<void(size_t)> &func);
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,118 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ValueIndex.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/Path.h"
+#include <unordered_set>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+ValueIndex::ValueIndex(SVFModule *svfModule, SVFIR *pag)
+{
+    // the modules in the order of their first function
+    vector<const Module*> modules;
+    unordered_set<const Module*> seen;
+    for (const SVFFunction *fun : svfModule->getFunctionSet()) {
+        const Module *module = fun->getLLVMFun()->getParent();
+        if (seen.insert(module).second) {
+            modules.push_back(module);
+        }
+    }
+    for (const Module *module : modules) {
+        for (const GlobalVariable &global : module->globals()) {
+            add(&global, pag);
+        }
+        for (const Function &func : *module) {
+            add(&func, pag);
+            for (const Argument &arg : func.args()) {
+                add(&arg, pag);
+            }
+            for (const Instruction &inst : instructions(func)) {
+                add(&inst, pag);
+            }
+        }
+    }
+}
+
+void ValueIndex::add(const Value *value, SVFIR *pag)
+{
+    if (!value->getType()->isPointerTy() || !pag->hasValueNode(value)) {
+        return;
+    }
+    string name = getName(value);
+    if (!name.empty()) {
+        insert(name, value);
+    }
+    auto inst = dyn_cast<Instruction>(value);
+    if (inst == NULL || !inst->getDebugLoc()) {
+        return;
+    }
+    const DILocation *loc = inst->getDebugLoc().get();
+    string line = ":" + to_string(loc->getLine());
+    string column = line + ":" + to_string(loc->getColumn());
+    // the file as compiled and without its directory
+    string file = loc->getFilename().str();
+    string base = sys::path::filename(file).str();
+    insert(file + line, value);
+    insert(file + column, value);
+    if (base != file) {
+        insert(base + line, value);
+        insert(base + column, value);
+    }
+}
+
+void ValueIndex::insert(const string &id, const Value *value)
+{
+    vector<const Value*> &list = values[id];
+    if (list.empty() || list.back() != value) {
+        list.push_back(value);
+    }
+}
+
+bool ValueIndex::find(const string &id, vector<const Value*> &result) const
+{
+    auto it = values.find(id);
+    if (it == values.end()) {
+        return false;
+    }
+    result.insert(result.end(), it->second.begin(), it->second.end());
+    return true;
+}
+
+string ValueIndex::getName(const Value *value)
+{
+    if (!value->hasName()) {
+        return "";
+    }
+    if (isa<GlobalValue>(value)) {
+        return "@" + value->getName().str();
+    }
+    const Function *func = NULL;
+    if (auto arg = dyn_cast<Argument>(value)) {
+        func = arg->getParent();
+    } else if (auto inst = dyn_cast<Instruction>(value)) {
+        func = inst->getFunction();
+    }
+    if (func == NULL) {
+        return "";
+    }
+    return func->getName().str() + ":" + value->getName().str();
+}
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef VALUEINDEX_H
+#define VALUEINDEX_H
+
+#include "SVF-FE/LLVMUtil.h"
+#include "llvm/IR/Value.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Pointer values of the program by identifier, for queries from outside a
+/// plugin. A value is identified by its name, @global for globals and
+/// functions, function:name for arguments and instructions, or by the
+/// source location of an instruction, file:line or file:line:column. A
+/// location stands for all pointers defined there, in instruction order.
+class ValueIndex
+{
+private:
+    std::unordered_map<std::string, std::vector<const llvm::Value*>> values;
+
+    void add(const llvm::Value *value, SVF::SVFIR *pag);
+    void insert(const std::string &id, const llvm::Value *value);
+
+public:
+    ValueIndex(SVF::SVFModule *svfModule, SVF::SVFIR *pag);
+
+    /// values of id, false if there is none
+    bool find(const std::string &id, std::vector<const llvm::Value*> &result) const;
+    /// name of value as used in identifiers, empty if it has none
+    static std::string getName(const llvm::Value *value);
+};
+
+#endif // VALUEINDEX_H
@@ -0,0 +1,283 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WorkerPool.h"
+#include "Program.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <poll.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace std;
+
+/// Messages between server and worker are a 64 bit length and the payload.
+/// Request: "<plugin address> <mode>\n<function>\n<arg>\n..." (arguments are
+/// single words, mode 1 runs the arguments as fused checkers), response: '1' or '0' for the return value of the plugin
+/// function and the serialized output.
+static bool writeMessage(int fd, const string &data)
+{
+    uint64_t size = data.size();
+    string buffer(reinterpret_cast<const char *>(&size), sizeof(size));
+    buffer += data;
+    size_t done = 0;
+    while (done < buffer.size()) {
+        ssize_t n = send(fd, buffer.data() + done, buffer.size() - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+/// read one message, timeout in seconds (0 waits forever)
+static bool readMessage(int fd, string &data, unsigned int timeout, bool &timedOut)
+{
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(timeout);
+    auto readAll = [&](char *buffer, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            if (timeout > 0) {
+                auto left = chrono::duration_cast<chrono::milliseconds>(
+                    deadline - chrono::steady_clock::now()).count();
+                struct pollfd pfd = {fd, POLLIN, 0};
+                int ready = left > 0 ? poll(&pfd, 1, left) : 0;
+                if (ready < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (ready == 0) {
+                    timedOut = true;
+                    return false;
+                }
+                if (ready < 0) {
+                    return false;
+                }
+            }
+            ssize_t n = read(fd, buffer + done, size - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    };
+    timedOut = false;
+    uint64_t size;
+    if (!readAll(reinterpret_cast<char *>(&size), sizeof(size))) {
+        return false;
+    }
+    data.resize(size);
+    return size == 0 || readAll(&data[0], size);
+}
+
+WorkerPool::WorkerPool(Program *program, unsigned int maxWorkers, unsigned int timeout,
+                       unsigned int memoryMB)
+    : program(program), maxWorkers(maxWorkers), timeout(timeout),
+      memoryLimit(static_cast<size_t>(memoryMB) << 20), running(0)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    for (auto &worker : idle) {
+        kill(worker);
+    }
+}
+
+bool WorkerPool::spawn(Worker &worker)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        return false;
+    }
+    // a worker which is forked while the program changes is only too old
+    worker.generation = program->getGeneration();
+    pid_t pid = program->forkWorker();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        serve(fds[1]);
+    }
+    close(fds[1]);
+    worker.pid = pid;
+    worker.fd = fds[0];
+    return true;
+}
+
+void WorkerPool::kill(Worker &worker)
+{
+    close(worker.fd);
+    ::kill(worker.pid, SIGKILL);
+    waitpid(worker.pid, NULL, 0);
+}
+
+void WorkerPool::serve(int fd)
+{
+    // the sockets of clients and other workers must not be held open
+    vector<int> fds;
+    if (DIR *dir = opendir("/proc/self/fd")) {
+        while (struct dirent *entry = readdir(dir)) {
+            int other = atoi(entry->d_name);
+            if (other > 2 && other != fd && other != dirfd(dir)) {
+                fds.push_back(other);
+            }
+        }
+        closedir(dir);
+    }
+    for (int other : fds) {
+        close(other);
+    }
+
+    // the limit is on top of the address space shared with the server
+    if (memoryLimit > 0) {
+        ifstream statm("/proc/self/statm");
+        size_t pages = 0;
+        statm >> pages;
+        struct rlimit limit;
+        limit.rlim_cur = pages * sysconf(_SC_PAGESIZE) + memoryLimit;
+        limit.rlim_max = limit.rlim_cur;
+        setrlimit(RLIMIT_AS, &limit);
+    }
+
+    while (true) {
+        string request;
+        bool timedOut;
+        if (!readMessage(fd, request, 0, timedOut)) {
+            _exit(0);
+        }
+        istringstream is(request);
+        uintptr_t address = 0;
+        int checkers = 0;
+        string funcName;
+        is >> address >> checkers;
+        is.ignore(1);
+        getline(is, funcName);
+        list<string> args;
+        string arg;
+        while (getline(is, arg)) {
+            args.push_back(arg);
+        }
+
+        Plugin *plugin = reinterpret_cast<Plugin *>(address);
+        BufferedSink sink;
+        bool ok = checkers ? program->runCheckers(plugin, args, sink)
+                           : plugin->run(funcName, args, sink);
+        sink.finish();
+        string response;
+        raw_string_ostream os(response);
+        os << (ok ? '1' : '0');
+        sink.write(os);
+        os.flush();
+        if (!writeMessage(fd, response)) {
+            _exit(0);
+        }
+    }
+}
+
+WorkerPool::Status WorkerPool::run(Plugin *plugin, const string &funcName,
+                                   const list<string> &args, BufferedSink &result, bool checkers)
+{
+    Worker worker;
+    bool found = false;
+    vector<Worker> stale;
+    {
+        unique_lock<mutex> guard(lock);
+        available.wait(guard, [&]() { return running < maxWorkers; });
+        running++;
+        unsigned long generation = program->getGeneration();
+        while (!idle.empty() && !found) {
+            worker = idle.back();
+            idle.pop_back();
+            if (worker.generation == generation) {
+                found = true;
+            } else {
+                stale.push_back(worker);
+            }
+        }
+    }
+    for (auto &w : stale) {
+        kill(w);
+    }
+    auto release = [&]() {
+        lock_guard<mutex> guard(lock);
+        running--;
+        available.notify_one();
+    };
+    if (!found && !spawn(worker)) {
+        result.text() << "Error: could not start worker: " << strerror(errno) << "\n";
+        release();
+        return CRASHED;
+    }
+
+    string request = to_string(reinterpret_cast<uintptr_t>(plugin)) + " " + (checkers ? "1" : "0") +
+                     "\n" + funcName + "\n";
+    for (auto &arg : args) {
+        request += arg + "\n";
+    }
+    string response;
+    bool timedOut = false;
+    if (!writeMessage(worker.fd, request) || !readMessage(worker.fd, response, timeout, timedOut) ||
+        response.empty()) {
+        // the status of a worker which died on its own is kept by the kill
+        close(worker.fd);
+        int status = 0;
+        ::kill(worker.pid, SIGKILL);
+        waitpid(worker.pid, &status, 0);
+        if (timedOut) {
+            result.text() << "Error: " << funcName << " timed out after " << timeout << " s\n";
+        } else if (WIFSIGNALED(status) && WTERMSIG(status) != SIGKILL) {
+            result.text() << "Error: " << funcName << " crashed: " << strsignal(WTERMSIG(status)) << "\n";
+        } else {
+            result.text() << "Error: " << funcName << " worker stopped unexpectedly\n";
+        }
+        release();
+        return CRASHED;
+    }
+
+    istringstream is(response.substr(1));
+    bool ok = response[0] == '1';
+    if (!result.read(is)) {
+        result.text() << "Error: invalid output of worker\n";
+        ok = false;
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        idle.push_back(worker);
+        running--;
+        available.notify_one();
+    }
+    return ok ? OK : FAILED;
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include "svf-plugin.h"
+#include "ResultSink.h"
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+class Program;
+
+/// Runs plugin functions in forked worker processes.
+///
+/// A worker is a copy-on-write fork of the server, it shares the built graphs
+/// and the loaded plugins with the server without copying them. A crash, a
+/// timeout or an exceeded memory limit only ends the worker, the next run
+/// forks a new one. Idle workers are reused as long as the program did not
+/// change since they were forked (see Program::getGeneration), so the
+/// plugins and graphs they see are always those of the server.
+class WorkerPool
+{
+public:
+    enum Status {
+        OK,
+        FAILED,     ///< the plugin function returned false
+        CRASHED,    ///< the worker died, timed out or the pipe broke
+    };
+
+private:
+    struct Worker {
+        pid_t pid;
+        int fd;
+        unsigned long generation;
+    };
+
+    Program *program;
+    unsigned int maxWorkers;
+    unsigned int timeout;
+    size_t memoryLimit;
+
+    std::vector<Worker> idle;
+    unsigned int running;
+    std::mutex lock;
+    std::condition_variable available;
+
+    bool spawn(Worker &worker);
+    void kill(Worker &worker);
+    /// request loop of a worker process, never returns
+    void serve(int fd);
+
+public:
+    /// timeout in seconds and memory limit in MB of a run, 0 for no limit
+    WorkerPool(Program *program, unsigned int maxWorkers, unsigned int timeout,
+               unsigned int memoryMB);
+    ~WorkerPool();
+
+    /// Run funcName of plugin in a worker, its output is collected in result.
+    /// If the worker crashed, result holds the error. With checkers, args are
+    /// checkers which are run fused (see Program::runCheckers) and funcName
+    /// only names the run in errors.
+    Status run(Plugin *plugin, const std::string &funcName, const std::list<std::string> &args,
+               BufferedSink &result, bool checkers = false);
+};
+
+#endif // WORKERPOOL_H
@@ -18,7 +18,9 @@
 #include "Util/SVFUtil.h"
 #include "svf-plugin.h"
 #include "WPA/Andersen.h"
+#include <atomic>
 #include <list>
+#include <memory>
 #include <regex>
 #include <boost/algorithm/string/predicate.hpp>
 
@@ -28,199 +30,217 @@ using namespace SVF;
 
 
 class MyPlugin : public Plugin {
-    ICFG* icfg;
-    SVFG *svfg;
+    SVFServer *server;
 
 public:
-    void init(ICFG* icfg, SVFG *svfg) {
-        this->icfg = icfg;
-        this->svfg = svfg;
+    void init(SVFServer *server) {
+        this->server = server;
     }
-    void help() {
-        SVFUtil::outs() << "plugin help\n";
-        SVFUtil::outs() << "    findAllMemcpys           finds and prints all memcpy calls\n";
-        SVFUtil::outs() << "    findArrayMemcpys         finds and prints all memcpy calls with array type dst buffer\n";
-        SVFUtil::outs() << "    findMissingRetCodeCheck  [ignore func, ...] finds missing return code checks\n";
+    void help(raw_ostream &os) {
+        os << "plugin help\n";
+        os << "    findAllMemcpys           finds and prints all memcpy calls\n";
+        os << "    findArrayMemcpys         finds and prints all memcpy calls with array type dst buffer\n";
+        os << "    findMissingRetCodeCheck  [ignore func, ...] finds missing return code checks\n";
     }
 
-    void run(string funcName, list<string> &args) {
+    unsigned int getRequirements(string funcName) {
+        if (funcName == "findMissingRetCodeCheck") {
+            return ICFG_ARTIFACT | SVFG_ARTIFACT;
+        }
+        return ICFG_ARTIFACT;
+    }
+
+    bool run(string funcName, list<string> &args, ResultSink &sink) {
         if (funcName == "findAllMemcpys") {
-            findAllMemcpys(args);
+            findAllMemcpys(args, sink);
         } else if (funcName == "findArrayMemcpys") {
-            findArrayMemcpys(args);
+            findArrayMemcpys(args, sink);
         } else if (funcName == "findMissingRetCodeCheck") {
-            findMissingRetCodeCheck(args);
+            findMissingRetCodeCheck(args, sink);
         } else {
-            SVFUtil::outs() << "Error: Could not find function name: " << funcName << "\n";
-            help();
+            sink.text() << "Error: Could not find function name: " << funcName << "\n";
+            help(sink.text());
+            return false;
         }
+        return true;
     }
 
-   llvm::Type *getBufferTypeInter(const ICFGNode *node, const Value *value, llvm::Type::TypeID *typeId) {
-        auto func = node->getFun();
-        //SVFUtil::outs() << "  dst var name: " << varName << " uses: " << value->getNumUses() << "\n";
-
-        node = (*node->getInEdges().begin())->getSrcNode();
-        bool load = false;
-        while (node->getInEdges().size() == 1) {
-            if (node->getFun() != func) {
-                // we do only intra-procedural analysis
-                *typeId = value->getType()->getTypeID();
-                return value->getType();
-            }
-            //SVFUtil::outs() << "    " << node->toString() << "\n";
-            for (auto &vnode : node->getSVFStmts()) {
-                auto inst = vnode->getInst();
-                if (auto g = dyn_cast<llvm::GetElementPtrInst>(inst)) {
-                    if (*g->use_begin() == value) {
-                        //SVFUtil::outs() << "  GetElementPtrInst name: " << v << "\n";
-                        auto t = g->getSourceElementType();
-                        *typeId = t->getTypeID();
-                        if (auto st = dyn_cast<llvm::StructType>(t)) {
-                            if (auto nr = dyn_cast<llvm::ConstantInt>(g->getOperand(2))) {
-                                auto el = st->getElementType(nr->getSExtValue());
-                                *typeId = el->getTypeID();
-                                return el;
-                            }
-                        }
-                        return t;
-                    }
-                } else if (auto g = dyn_cast<llvm::SExtInst>(inst)) {
-                    if (load) {
-                        *typeId = value->getType()->getTypeID();
-                        return value->getType();
-                    }
-                    if (*g->use_begin() == value) {
-                        *typeId = value->getType()->getTypeID();
-                        //SVFUtil::outs() << "  SExtInst name: " << v << "\n";
-                        return value->getType();
-                    }
-                } else if (auto g = dyn_cast<llvm::ZExtInst>(inst)) {
-                    if (load) {
-                        *typeId = value->getType()->getTypeID();
-                        return value->getType();
-                    }
-                    if (*g->use_begin() == value) {
-                        *typeId = value->getType()->getTypeID();
-                        //SVFUtil::outs() << "  ZExtInst name: " << v << "\n";
-                        return value->getType();
-                    }
-                } else if (auto g = dyn_cast<llvm::LoadInst>(inst)) {
-                    if (load) {
-                        *typeId = value->getType()->getTypeID();
-                        return value->getType();
-                    }
-                    if (*g->use_begin() == value) {
-                        //SVFUtil::outs() << "  LoadInst name: " << v << " -> " << d << "\n";
-                        value = g->getPointerOperand();
-                        load = true;
-                    }
-                } else {
-                    // unsupported instruction for value tracing, abort
-                    *typeId = value->getType()->getTypeID();
-                    return value->getType();
+    vector<string> getCheckers() {
+        return {"findAllMemcpys", "findArrayMemcpys", "findMissingRetCodeCheck"};
+    }
+
+    bool registerChecker(string funcName, list<string> &args, CheckerVisitors &visitors) {
+        // the counters are shared by the callbacks of one traversal
+        shared_ptr<atomic<int>> count(new atomic<int>(0));
+        if (funcName == "findAllMemcpys" || funcName == "findArrayMemcpys") {
+            bool all = funcName == "findAllMemcpys";
+            visitors.onICFGNode(ICFGNode::FunCallBlock, [this, all, count](const ICFGNode *n, ResultSink &sink) {
+                auto c = static_cast<const CallBlockNode*>(n);
+                if (isMemcpy(c) && (all ? checkMemcpy(c, sink) : checkArrayMemcpy(c, sink))) {
+                    (*count)++;
+                }
+            });
+            visitors.onFinish([count](ResultSink &sink) {
+                sink.text() << "Found " << count->load() << " memcpy calls\n";
+            });
+        } else if (funcName == "findMissingRetCodeCheck") {
+            SVFG *svfg = server->getSVFG();
+            const SVFGNodeTable *svfgTable = &server->getSVFGTable();
+            visitors.onICFGNode(ICFGNode::FunRetBlock, [args, svfg, svfgTable, count](const ICFGNode *n, ResultSink &sink) {
+                if (checkRetCode(static_cast<const RetBlockNode*>(n), args, svfg, *svfgTable, sink)) {
+                    (*count)++;
                 }
+            });
+            visitors.onFinish([count](ResultSink &sink) {
+                sink.text() << "Found " << count->load() << " missing return code checks\n";
+            });
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /// source location of a call node
+    static string getCallLoc(const CallBlockNode *c) {
+        // calls without arguments or return value have no statements
+        if (c->getSVFStmts().empty()) {
+            return SVFUtil::getSourceLoc(c->getCallSite());
+        }
+        return SVFUtil::getSourceLoc((*c->getSVFStmts().begin())->getInst());
+    }
+
+    /// direct call of llvm.memcpy.*, as found by getCallSitesByPrefix
+    static bool isMemcpy(const CallBlockNode *c) {
+        auto call = dyn_cast<CallBase>(c->getCallSite());
+        if (call == NULL) {
+            return false;
+        }
+        auto func = dyn_cast<Function>(call->getCalledOperand()->stripPointerCasts());
+        return func != NULL && func->getName().startswith("llvm.memcpy");
+    }
+
+    bool checkMemcpy(const CallBlockNode *c, ResultSink &sink) {
+        auto opt1 = c->getActualParms()[0]->getValue();
+        llvm::Type::TypeID typeId = server->getBufferType(opt1)->getTypeID();
+        Finding finding;
+        finding.kind = "memcpy";
+        finding.function = string(c->getFun()->getName());
+        finding.location = getCallLoc(c);
+        if (typeId == llvm::Type::ArrayTyID) {
+            finding.message = "array type";
+        } else if (typeId == llvm::Type::StructTyID) {
+            finding.message = "struct type";
+        } else if (typeId == llvm::Type::PointerTyID) {
+            finding.message = "pointer type";
+        } else {
+            finding.message = "other type";
+        }
+        sink.emit(finding);
+        return true;
+    }
+
+    bool checkArrayMemcpy(const CallBlockNode *c, ResultSink &sink) {
+        auto opt1 = c->getActualParms()[0]->getValue();
+        auto bufferType = server->getBufferType(opt1);
+        if (!bufferType->isArrayTy()) {
+            return false;
+        }
+        auto op2 = c->getActualParms()[2]->getValue();
+        int bufferSize = bufferType->getArrayNumElements();
+        Finding finding;
+        finding.function = string(c->getFun()->getName());
+        finding.location = getCallLoc(c);
+        if (auto i = dyn_cast<const llvm::ConstantInt>(op2)) {
+            auto len = i->getSExtValue();
+            if (len <= bufferSize) {
+                // buffer size ok
+                return false;
             }
-            node = (*node->getInEdges().begin())->getSrcNode();
+            finding.kind = "memcpy-overflow";
+            finding.message = "len: " + to_string(len) + " buffer size: " + to_string(bufferSize);
+        } else {
+            finding.kind = "memcpy-variable-len";
         }
-        *typeId = value->getType()->getTypeID();
-        return value->getType();
+        sink.emit(finding);
+        return true;
     }
 
-    void findAllMemcpys(list<string> &args) {
+    static bool checkRetCode(const RetBlockNode *en, const list<string> &ignore, SVFG *svfg,
+                             const SVFGNodeTable &svfgTable, ResultSink &sink) {
+        auto callSite = en->getCallBlockNode()->getCallSite();
+        auto call = dyn_cast<CallInst>(callSite);
+        if (call == NULL) {
+            sink.text() << "Error: could not cast CallSite to CallInst\n";
+            return false;
+        }
+        auto func = call->getCalledFunction();
+        string funcName = "???";
+        if (func != NULL) {
+            funcName = string(func->getName());
+        }
+        if (find(ignore.begin(), ignore.end(), funcName) != ignore.end()) {
+            // ignore this function
+            return false;
+        }
+        auto retVar = en->getActualRet();
+        if (retVar == NULL) {
+            return false;
+        }
+        if (!svfg->hasDefSVFGNode(retVar)) {
+            return false;
+        }
+        const VFGNode* vNode = svfg->getDefSVFGNode(retVar);
+        uint32_t row = svfgTable.getRow(vNode->getId());
+        if (row == SVFGNodeTable::npos || svfgTable.getOutDegree(row) != 0) {
+            return false;
+        }
+        Finding finding;
+        finding.kind = "missing-retcode-check";
+        finding.function = string(en->getFun()->getName());
+        finding.location = SVFUtil::getSourceLoc(retVar->getValue());
+        finding.message = "-> " + funcName;
+        sink.emit(finding);
+        return true;
+    }
+
+    void findAllMemcpys(list<string> &args, ResultSink &sink) {
         (void)args;
         int count = 0;
-        for(ICFG::iterator i = icfg->begin(); i != icfg->end(); i++) {
-            ICFGNode *n = i->second;
-            if (n->getNodeKind() == ICFGNode::FunCallBlock) {
-                CallBlockNode *c = static_cast<CallBlockNode *>(n);
-                if (c->toString().find("@llvm.memcpy") != string::npos) {
-                    SVFUtil::outs() << "* " << c->toString() << "\n";
-                    auto opt1 = c->getActualParms()[0]->getValue();
-                    llvm::Type::TypeID typeId;
-                    getBufferTypeInter(n, opt1, &typeId);
-                    if (typeId == llvm::Type::ArrayTyID) {
-                        SVFUtil::outs() << "  array type\n";
-                    } else if (typeId == llvm::Type::StructTyID) {
-                        SVFUtil::outs() << "  struct type\n";
-                    } else if (typeId == llvm::Type::PointerTyID) {
-                        SVFUtil::outs() << "  pointer type\n";
-                    } else {
-                        SVFUtil::outs() << "  other type\n";
-                    }
-                    count++;
-                }
+        CallSiteList calls;
+        server->getCallSitesByPrefix("llvm.memcpy", calls);
+        for (auto &callSite : calls) {
+            if (checkMemcpy(callSite.call, sink)) {
+                count++;
             }
         }
-        SVFUtil::outs() << "Found " << count << " memcpy calls\n";
+        sink.text() << "Found " << count << " memcpy calls\n";
     }
 
-    void findArrayMemcpys(list<string> &args) {
+    void findArrayMemcpys(list<string> &args, ResultSink &sink) {
         (void)args;
         int count = 0;
-        for(ICFG::iterator i = icfg->begin(); i != icfg->end(); i++) {
-            ICFGNode *n = i->second;
-            if (n->getNodeKind() == ICFGNode::FunCallBlock) {
-                CallBlockNode *c = static_cast<CallBlockNode *>(n);
-                if (c->toString().find("@llvm.memcpy") != string::npos) {
-                    auto opt1 = c->getActualParms()[0]->getValue();
-                    llvm::Type::TypeID typeId;
-                    auto bufferType = getBufferTypeInter(n, opt1, &typeId);
-                    if (typeId == llvm::Type::ArrayTyID) {
-                        auto op2 = c->getActualParms()[2]->getValue();
-                        int bufferSize = bufferType->getArrayNumElements();
-                        if (auto i = dyn_cast<const llvm::ConstantInt>(op2)) {
-                            auto len = i->getSExtValue();
-                            if (len > bufferSize) {
-                                SVFUtil::outs() << "! " << c->getFun()->getName() << " " << SVFUtil::getSourceLoc((*c->getSVFStmts().begin())->getInst()) << "\n";
-                                SVFUtil::outs() << "   len: " << len << " buffer size: " << bufferSize << "\n";
-                                count++;
-                            } else {
-                                // buffer size ok
-                            }
-                        } else {
-                            SVFUtil::outs() << "* " << c->getFun()->getName() << " " << SVFUtil::getSourceLoc((*c->getSVFStmts().begin())->getInst()) << "\n";
-                            count++;
-                        }
-                    }
-                }
+        CallSiteList calls;
+        server->getCallSitesByPrefix("llvm.memcpy", calls);
+        for (auto &callSite : calls) {
+            if (checkArrayMemcpy(callSite.call, sink)) {
+                count++;
             }
         }
-        SVFUtil::outs() << "Found " << count << " memcpy calls\n";
+        sink.text() << "Found " << count << " memcpy calls\n";
     }
 
-    void findMissingRetCodeCheck(list<string> &args) {
-        int count = 0;
-        for (auto i = this->icfg->begin(); i != this->icfg->end(); i++) {
-            auto n = i->second;
-            if (n->getNodeKind() == ICFGNode::FunRetBlock) {
-                auto en = static_cast<RetBlockNode*>(n);
-                auto callSite = en->getCallBlockNode()->getCallSite();
-                if (auto call = dyn_cast<CallInst>(callSite)) {
-                    auto func = call->getCalledFunction();
-                    string funcName = "???";
-                    if (func != NULL) {
-                        funcName = string(func->getName());
-                    }
-                    if (find(args.begin(), args.end(), funcName) != args.end()) {
-                        // ignore this function
-                        continue;
-                    }
-                    auto retVar = en->getActualRet();
-                    if (retVar != NULL) {
-                        const VFGNode* vNode = this->svfg->getDefSVFGNode(retVar);
-                        if (vNode->getOutEdges().size() == 0) {
-                            SVFUtil::outs() << "* " << n->getFun()->getName() << " -> " << funcName << " " << SVFUtil::getSourceLoc(retVar->getValue()) << "\n";
-                            count++;
-                        }
-                    }
-                } else {
-                    SVFUtil::outs() << "Error: could not cast CallSite to CallInst\n";
-                }
+    /// sharded over the return nodes of the ICFG table's kind index, the use
+    /// count of return values is read from the SVFG table
+    void findMissingRetCodeCheck(list<string> &args, ResultSink &sink) {
+        SVFG *svfg = server->getSVFG();
+        const SVFGNodeTable &svfgTable = server->getSVFGTable();
+        atomic<int> count(0);
+        server->parallelForICFGKind(ICFGNode::FunRetBlock, [&](const ICFGNode *n, ResultSink &shard) {
+            if (checkRetCode(static_cast<const RetBlockNode*>(n), args, svfg, svfgTable, shard)) {
+                count++;
             }
-
-        }
-        SVFUtil::outs() << "Found " << count << " missing return code checks\n";
+        }, sink);
+        sink.text() << "Found " << count.load() << " missing return code checks\n";
     }
 };
 
@@ -18,14 +18,202 @@
 #ifndef SVFSERVER_H
 #define SVFSERVER_H
 #include "Graphs/SVFG.h"
+#include "NodeTable.h"
 #include <string>
 #include <list>
+#include <vector>
+#include <functional>
+#include <utility>
+
+/// Analysis artifacts a plugin function can depend on
+enum Artifact {
+    ICFG_ARTIFACT = 1 << 0,
+    CALLGRAPH_ARTIFACT = 1 << 1,
+    PTA_ARTIFACT = 1 << 2,
+    SVFG_ARTIFACT = 1 << 3,
+    VFG_ARTIFACT = 1 << 4,
+    DDA_ARTIFACT = 1 << 5,      ///< demand-driven points-to and value-flow queries
+};
+
+/// Answer of a demand-driven query
+enum DemandResult {
+    DEMAND_NO,              ///< disproved
+    DEMAND_MAY,             ///< holds for the complete result
+    DEMAND_OUT_OF_BUDGET,   ///< not disproved before the budget ran out
+};
+
+/// A call site and its return node
+struct CallSiteEntry {
+    const SVF::CallBlockNode *call;
+    const SVF::RetBlockNode *ret;
+};
+typedef std::vector<CallSiteEntry> CallSiteList;
+
+typedef NodeTable<SVF::ICFGNode> ICFGNodeTable;
+typedef NodeTable<SVF::VFGNode> SVFGNodeTable;
+
+typedef std::pair<const llvm::Value*, const llvm::Value*> ValuePair;
+
+/// One result of a checker
+struct Finding {
+    std::string kind;       ///< checker specific class, e.g. "missing-retcode-check"
+    std::string function;   ///< function containing the finding
+    std::string location;   ///< source location
+    std::string message;
+};
+
+/// Receives the output of a plugin run. The server renders findings as
+/// human readable text or as JSON lines, depending on the session.
+class ResultSink {
+public:
+    virtual ~ResultSink() {}
+    virtual void emit(const Finding &finding) = 0;
+    /// free text output like summaries and errors
+    virtual llvm::raw_ostream& text() = 0;
+};
+
+/// Visits one node of a parallel traversal. Output must be written to sink,
+/// it is merged into the output of the traversal in node order.
+typedef std::function<void(const SVF::ICFGNode *node, ResultSink &sink)> ICFGNodeVisitor;
+typedef std::function<void(const SVF::VFGNode *node, ResultSink &sink)> SVFGNodeVisitor;
+
+/// Callbacks of one checker for a fused traversal ("run-all"). The graphs
+/// are traversed once for all checkers, at every node the callbacks of all
+/// checkers registered for its kind are called. As in parallelForICFG, the
+/// callbacks run concurrently, their output is written in node order, one
+/// checker after the other.
+class CheckerVisitors {
+public:
+    typedef std::function<void(ResultSink &sink)> Finisher;
+
+    /// call visitor for every ICFG node of kind, an SVF::ICFGNode::ICFGNodeK
+    void onICFGNode(int kind, const ICFGNodeVisitor &visitor) {
+        icfgVisitors.push_back(std::make_pair(kind, visitor));
+    }
+    /// call visitor for every SVFG node of kind, an SVF::VFGNode::VFGNodeK
+    void onSVFGNode(int kind, const SVFGNodeVisitor &visitor) {
+        svfgVisitors.push_back(std::make_pair(kind, visitor));
+    }
+    /// call finisher after the traversal, e.g. to write a summary
+    void onFinish(const Finisher &finisher) {
+        finishers.push_back(finisher);
+    }
+
+    const std::vector<std::pair<int, ICFGNodeVisitor>>& getICFGVisitors() const {
+        return icfgVisitors;
+    }
+    const std::vector<std::pair<int, SVFGNodeVisitor>>& getSVFGVisitors() const {
+        return svfgVisitors;
+    }
+    const std::vector<Finisher>& getFinishers() const {
+        return finishers;
+    }
+
+private:
+    std::vector<std::pair<int, ICFGNodeVisitor>> icfgVisitors;
+    std::vector<std::pair<int, SVFGNodeVisitor>> svfgVisitors;
+    std::vector<Finisher> finishers;
+};
+
+/// Access to the analyzed program. Every artifact is built on first access
+/// and cached for all later runs.
+class SVFServer {
+public:
+    virtual ~SVFServer() {}
+    virtual SVF::ICFG* getICFG() = 0;
+    virtual SVF::PTACallGraph* getCallGraph() = 0;
+    virtual SVF::PointerAnalysis* getPTA() = 0;
+    virtual SVF::SVFG* getSVFG() = 0;
+    virtual SVF::VFG* getVFG() = 0;
+
+    /// Call sites calling the function callee. Indirect call sites are
+    /// included once the call graph is built, plugin functions which need
+    /// them require CALLGRAPH_ARTIFACT.
+    virtual const CallSiteList& getCallSites(const std::string &callee) = 0;
+    /// Call sites calling any function whose name starts with prefix,
+    /// e.g. "llvm.memcpy", in ICFG order
+    virtual void getCallSitesByPrefix(const std::string &prefix, CallSiteList &callSites) = 0;
+
+    /// Flat node tables of the ICFG and the SVFG of the active analysis,
+    /// built on first use after the graph. Require the graph.
+    virtual const ICFGNodeTable& getICFGTable() = 0;
+    virtual const SVFGNodeTable& getSVFGTable() = 0;
+
+    /// Type of the buffer the pointer value points into: the array or the
+    /// struct field addressed by a GEP, also through one load of a pointer
+    /// stored there, otherwise the type of the value itself. Resolved once
+    /// per function and cached for all runs.
+    virtual llvm::Type* getBufferType(const llvm::Value *value) = 0;
+
+    /// Demand-driven, context-sensitive points-to set of a pointer, for
+    /// checkers which only ask about a few pointers. budget limits the steps
+    /// of the query, 0 selects the server default. Returns false if value is
+    /// no pointer or the query ran out of budget, pts then holds the result
+    /// of the pre-analysis. Results are cached for all runs. Requires
+    /// DDA_ARTIFACT.
+    virtual bool getDemandPointsTo(const llvm::Value *value, SVF::PointsTo &pts,
+                                   unsigned int budget) = 0;
+    /// DEMAND_NO if the points-to sets are disjoint, also if a query ran out
+    /// of budget and the sets of the pre-analysis are disjoint. Values which
+    /// are no pointers may alias anything.
+    virtual DemandResult mayAlias(const llvm::Value *a, const llvm::Value *b, unsigned int budget) = 0;
+    /// Whether the pointer value from may flow into the pointer to along the
+    /// def-use chains of the demand-driven analysis' pointer-only SVFG.
+    /// budget limits the visited nodes, 0 selects the server default.
+    /// Results are cached for all runs. Requires DDA_ARTIFACT.
+    virtual DemandResult mayFlow(const llvm::Value *from, const llvm::Value *to, unsigned int budget) = 0;
+
+    /// Pointer values with the identifier id: @global, function:name or the
+    /// source location file:line[:column] of instructions. Returns false if
+    /// there is none.
+    virtual bool findValues(const std::string &id, std::vector<const llvm::Value*> &values) = 0;
+    /// Whole-program points-to sets of a batch of values, pts[i] belongs to
+    /// values[i] and is empty if it is no pointer. Sets are cached for all
+    /// runs. Requires PTA_ARTIFACT.
+    virtual void queryPointsTo(const std::vector<const llvm::Value*> &values,
+                               std::vector<SVF::PointsTo> &pts) = 0;
+    /// aliases[i] is false only if the points-to sets of pairs[i] are disjoint
+    virtual void queryAliases(const std::vector<ValuePair> &pairs, std::vector<bool> &aliases) = 0;
+
+    /// Visit all nodes of the ICFG or SVFG on all cores. The nodes are split
+    /// into shards of consecutive node IDs, the output of every shard is
+    /// buffered and written to sink in shard order, so the output is the
+    /// same as of a sequential traversal. The visitor runs concurrently and
+    /// must only read the graphs it required before the run.
+    virtual void parallelForICFG(const ICFGNodeVisitor &visitor, ResultSink &sink) = 0;
+    virtual void parallelForSVFG(const SVFGNodeVisitor &visitor, ResultSink &sink) = 0;
+    /// Same for the ICFG nodes of one kind, e.g. ICFGNode::FunRetBlock,
+    /// taken from the kind index of the ICFG table in node ID order
+    virtual void parallelForICFGKind(unsigned int kind, const ICFGNodeVisitor &visitor, ResultSink &sink) = 0;
+};
 
 class Plugin {
 public:
-    virtual void init(SVF::ICFG* icfg, SVF::SVFG *svfg) = 0;
-    virtual void help() = 0;
-    virtual void run(std::string funcName, std::list<std::string> &args) = 0;
+    virtual ~Plugin() {}
+    virtual void init(SVFServer *server) = 0;
+    virtual void help(llvm::raw_ostream &os) = 0;
+    /// Artifacts (bitwise or of Artifact) used by funcName, the server builds
+    /// them before run is called
+    virtual unsigned int getRequirements(std::string funcName) = 0;
+    /// Run funcName and write all output to sink. Several runs may execute
+    /// concurrently on behalf of different clients. Returns false if the
+    /// function failed, batch mode then exits with an error status.
+    virtual bool run(std::string funcName, std::list<std::string> &args, ResultSink &sink) = 0;
+
+    /// functions which can also be registered as checkers
+    virtual std::vector<std::string> getCheckers() {
+        return std::vector<std::string>();
+    }
+    /// Register the callbacks of checker funcName for a fused traversal.
+    /// The output must be the same as of run. Returns false if funcName is
+    /// no checker.
+    virtual bool registerChecker(std::string funcName, std::list<std::string> &args,
+                                 CheckerVisitors &visitors) {
+        (void)funcName;
+        (void)args;
+        (void)visitors;
+        return false;
+    }
 };
 
 typedef Plugin* (*svf_analyzer)();
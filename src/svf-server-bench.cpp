@@ -0,0 +1,435 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Util/SVFUtil.h"
+#include "svf-plugin.h"
+#include "Program.h"
+#include "BuildStats.h"
+#include "ResultSink.h"
+#include "ThreadPool.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Path.h"
+#include <chrono>
+#include <dlfcn.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+static llvm::cl::list<std::string> Inputs(cl::Positional,
+        llvm::cl::desc("[input bitcode ...] (default: generated fixtures)"));
+
+static llvm::cl::list<unsigned int> Sizes("sizes", cl::CommaSeparated,
+        llvm::cl::desc("Functions of the generated fixtures (default 100,1000,10000)"));
+
+static llvm::cl::opt<std::string> FixtureDir("fixtures",
+        llvm::cl::desc("Directory of the generated fixtures, created if missing"),
+        llvm::cl::init("bench-fixtures"));
+
+static llvm::cl::opt<std::string> PluginPath("plugin",
+        llvm::cl::desc("Plugin with the benchmarked commands"),
+        llvm::cl::init(SVF_PLUGIN_PATH));
+
+static llvm::cl::opt<unsigned int> Repeat("repeat",
+        llvm::cl::desc("Runs of every plugin command, the fastest is reported"),
+        llvm::cl::init(3));
+
+static llvm::cl::opt<unsigned int> Threads("threads",
+        llvm::cl::desc("Number of threads for parallel graph traversals (0 = one per core)"),
+        llvm::cl::init(0));
+
+static llvm::cl::opt<std::string> Format("format",
+        llvm::cl::desc("Output format: csv or json"),
+        llvm::cl::init("csv"));
+
+static llvm::cl::opt<std::string> OutputFile("o",
+        llvm::cl::desc("Write the results to this file instead of stdout"),
+        llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> Baseline("baseline",
+        llvm::cl::desc("Compare against the results of an earlier run, written as csv"),
+        llvm::cl::init(""));
+
+static llvm::cl::opt<unsigned int> Tolerance("tolerance",
+        llvm::cl::desc("Allowed slowdown and memory growth against the baseline in percent"),
+        llvm::cl::init(20));
+
+/// plugin commands which are benchmarked, all of them also fused
+static const vector<string> commands = {"findAllMemcpys", "findArrayMemcpys", "findMissingRetCodeCheck"};
+
+/// one measured step of a fixture
+struct Row {
+    string fixture;
+    string step;
+    double wallTime;    ///< seconds
+    long peakRSS;       ///< KB, of the process after the step
+    unsigned int nodes;
+    long rssDelta;      ///< KB, change of the resident set size during the step
+
+    double getNodesPerSecond() const {
+        return wallTime > 0 ? nodes / wallTime : 0;
+    }
+};
+
+/// Write a program of n functions. Every function copies into a fixed size
+/// array with constant and variable length, passes pointers through a
+/// global and calls two earlier functions, ignoring the return value of the
+/// second. The findings and the graph sizes grow linearly with n.
+static bool writeFixture(const string &path, unsigned int n)
+{
+    error_code ec;
+    raw_fd_ostream os(path, ec);
+    if (ec) {
+        errs() << "Error: could not write " << path << ": " << ec.message() << "\n";
+        return false;
+    }
+    os << "; generated by svf-server-bench, " << n << " functions\n";
+    os << "declare void @llvm.memcpy.p0i8.p0i8.i64(i8* noalias nocapture writeonly, "
+          "i8* noalias nocapture readonly, i64, i1 immarg)\n\n";
+    for (unsigned int i = 0; i < n; i++) {
+        os << "@g" << i << " = global i8* null\n";
+    }
+    os << "\ndefine i32 @f0(i8* %src, i32 %n) {\nentry:\n  ret i32 %n\n}\n";
+    for (unsigned int i = 1; i < n; i++) {
+        os << "\ndefine i32 @f" << i << "(i8* %src, i32 %n) {\n";
+        os << "entry:\n";
+        os << "  %buf = alloca [16 x i8], align 1\n";
+        os << "  %dst = getelementptr inbounds [16 x i8], [16 x i8]* %buf, i64 0, i64 0\n";
+        os << "  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %dst, i8* %src, i64 32, i1 false)\n";
+        os << "  %len = zext i32 %n to i64\n";
+        os << "  call void @llvm.memcpy.p0i8.p0i8.i64(i8* %dst, i8* %src, i64 %len, i1 false)\n";
+        os << "  store i8* %dst, i8** @g" << i << "\n";
+        os << "  %p = load i8*, i8** @g" << (i * 7) % n << "\n";
+        os << "  %r = call i32 @f" << i - 1 << "(i8* %src, i32 %n)\n";
+        os << "  %u = call i32 @f" << i / 2 << "(i8* %p, i32 %r)\n";
+        os << "  ret i32 %r\n";
+        os << "}\n";
+    }
+    os << "\ndefine i32 @main() {\n";
+    os << "entry:\n";
+    os << "  %buf = alloca [64 x i8], align 1\n";
+    os << "  %p = getelementptr inbounds [64 x i8], [64 x i8]* %buf, i64 0, i64 0\n";
+    os << "  %r = call i32 @f" << n - 1 << "(i8* %p, i32 64)\n";
+    os << "  ret i32 %r\n";
+    os << "}\n";
+    return true;
+}
+
+static double since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+/// Build all graphs of the fixture and run the plugin commands, in the
+/// forked child of the fixture
+static bool benchFixture(const string &path, Plugin *plugin, vector<Row> &rows)
+{
+    string fixture = sys::path::filename(path).str();
+    Program program({path}, NULL, NULL, "andersen");
+    plugin->init(&program);
+
+    // every require builds the next phases, the build statistics time them
+    unsigned int requirements[] = {ICFG_ARTIFACT, PTA_ARTIFACT | CALLGRAPH_ARTIFACT, SVFG_ARTIFACT};
+    size_t measured = 0;
+    for (unsigned int artifacts : requirements) {
+        program.require(artifacts);
+        vector<BuildStats::Phase> phases = program.getStats().getPhases();
+        for (; measured < phases.size(); measured++) {
+            const BuildStats::Phase &phase = phases[measured];
+            rows.push_back({fixture, phase.name, phase.wallTime, BuildStats::getPeakRSS(), phase.nodes,
+                            phase.rssDelta});
+        }
+    }
+
+    unsigned int icfgNodes = program.getICFGTable().size();
+    auto bench = [&](const string &step, const function<bool(ResultSink&)> &run) {
+        double best = 0;
+        // the first repetition fills the caches of the program
+        long rssDelta = 0;
+        for (unsigned int i = 0; i < max(1u, Repeat.getValue()); i++) {
+            BufferedSink sink;
+            long rss = BuildStats::getRSS();
+            auto start = chrono::steady_clock::now();
+            if (!run(sink)) {
+                sink.finish();
+                StreamSink out(errs(), StreamSink::TEXT);
+                sink.replay(out);
+                errs() << "Error: " << step << " failed on " << fixture << "\n";
+                return false;
+            }
+            double wallTime = since(start);
+            best = i == 0 ? wallTime : min(best, wallTime);
+            if (i == 0) {
+                rssDelta = BuildStats::getRSS() - rss;
+            }
+        }
+        rows.push_back({fixture, step, best, BuildStats::getPeakRSS(), icfgNodes, rssDelta});
+        return true;
+    };
+    for (auto &command : commands) {
+        list<string> args;
+        if (!bench("run " + command, [&](ResultSink &sink) { return plugin->run(command, args, sink); })) {
+            return false;
+        }
+    }
+    list<string> names(commands.begin(), commands.end());
+    return bench("run-all", [&](ResultSink &sink) { return program.runCheckers(plugin, names, sink); });
+}
+
+/// Rows are passed from the child of a fixture as csv lines
+static void writeCSV(raw_ostream &os, const vector<Row> &rows)
+{
+    // rss_delta_kb comes last, so baselines without it can still be read
+    os << "fixture,step,wall_s,process_peak_rss_kb,nodes,nodes_per_s,rss_delta_kb\n";
+    for (auto &row : rows) {
+        os << row.fixture << "," << row.step << format(",%.6f,", row.wallTime) << row.peakRSS << ","
+           << row.nodes << format(",%.0f,", row.getNodesPerSecond()) << row.rssDelta << "\n";
+    }
+}
+
+static void writeJSON(raw_ostream &os, const vector<Row> &rows)
+{
+    os << "[";
+    bool first = true;
+    for (auto &row : rows) {
+        os << (first ? "\n" : ",\n");
+        os << "  {\"fixture\": \"" << row.fixture << "\", \"step\": \"" << row.step << "\"";
+        os << format(", \"wall\": %.6f", row.wallTime) << ", \"process_peak_rss_kb\": " << row.peakRSS
+           << ", \"rss_delta_kb\": " << row.rssDelta;
+        os << ", \"nodes\": " << row.nodes << format(", \"nodes_per_s\": %.0f}", row.getNodesPerSecond());
+        first = false;
+    }
+    os << "\n]\n";
+}
+
+static bool readCSV(istream &is, vector<Row> &rows)
+{
+    string line;
+    if (!getline(is, line)) {
+        return false;
+    }
+    while (getline(is, line)) {
+        istringstream fields(line);
+        Row row;
+        string wallTime, peakRSS, nodes, nodesPerSecond, rssDelta;
+        if (!getline(fields, row.fixture, ',') || !getline(fields, row.step, ',') ||
+            !getline(fields, wallTime, ',') || !getline(fields, peakRSS, ',') ||
+            !getline(fields, nodes, ',')) {
+            return false;
+        }
+        row.wallTime = atof(wallTime.c_str());
+        row.peakRSS = atol(peakRSS.c_str());
+        row.nodes = atoi(nodes.c_str());
+        getline(fields, nodesPerSecond, ',');
+        getline(fields, rssDelta, ',');
+        row.rssDelta = atol(rssDelta.c_str());
+        rows.push_back(row);
+    }
+    return true;
+}
+
+/// Run one fixture in a child process, so every fixture starts with a fresh
+/// heap and peak RSS and a crash does not end the benchmark
+static bool runFixture(const string &path, Plugin *plugin, vector<Row> &rows)
+{
+    int fds[2];
+    if (pipe(fds) < 0) {
+        return false;
+    }
+    SVFUtil::outs().flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        vector<Row> childRows;
+        bool ok = benchFixture(path, plugin, childRows);
+        {
+            raw_fd_ostream os(fds[1], true);
+            writeCSV(os, childRows);
+        }
+        SVFUtil::outs().flush();
+        _exit(ok ? 0 : 1);
+    }
+    close(fds[1]);
+    string output;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fds[0], buffer, sizeof(buffer))) > 0 || (n < 0 && errno == EINTR)) {
+        if (n > 0) {
+            output.append(buffer, n);
+        }
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    istringstream is(output);
+    readCSV(is, rows);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        errs() << "Error: benchmark of " << path << " failed\n";
+        return false;
+    }
+    return true;
+}
+
+/// peak RSS of every fixture, the process peak only grows from step to step
+static map<string, long> getFixturePeaks(const vector<Row> &rows)
+{
+    map<string, long> peaks;
+    for (auto &row : rows) {
+        peaks[row.fixture] = max(peaks[row.fixture], row.peakRSS);
+    }
+    return peaks;
+}
+
+/// Report steps which are slower or grow the resident set more than in the
+/// baseline, and fixtures with a larger peak RSS. Differences below 10 ms
+/// or 1 MB are noise on small fixtures.
+static bool compareBaseline(const vector<Row> &rows, const vector<Row> &baseline)
+{
+    map<pair<string, string>, const Row*> base;
+    for (auto &row : baseline) {
+        base[make_pair(row.fixture, row.step)] = &row;
+    }
+    double factor = 1 + Tolerance / 100.0;
+    bool ok = true;
+    for (auto &row : rows) {
+        auto it = base.find(make_pair(row.fixture, row.step));
+        if (it == base.end()) {
+            continue;
+        }
+        const Row &old = *it->second;
+        if (row.wallTime > old.wallTime * factor && row.wallTime - old.wallTime > 0.01) {
+            errs() << "regression: " << row.fixture << " " << row.step
+                   << format(": %.3f s, baseline %.3f s\n", row.wallTime, old.wallTime);
+            ok = false;
+        }
+        if (row.rssDelta > max(old.rssDelta, 0L) * factor && row.rssDelta - old.rssDelta > 1024) {
+            errs() << "regression: " << row.fixture << " " << row.step << ": rss grew by "
+                   << row.rssDelta / 1024 << " MB, baseline " << old.rssDelta / 1024 << " MB\n";
+            ok = false;
+        }
+    }
+    map<string, long> oldPeaks = getFixturePeaks(baseline);
+    for (auto &peak : getFixturePeaks(rows)) {
+        auto it = oldPeaks.find(peak.first);
+        if (it == oldPeaks.end()) {
+            continue;
+        }
+        if (peak.second > it->second * factor && peak.second - it->second > 1024) {
+            errs() << "regression: " << peak.first << ": peak rss " << peak.second / 1024
+                   << " MB, baseline " << it->second / 1024 << " MB\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char ** argv)
+{
+    cl::ParseCommandLineOptions(argc, argv, "Benchmark of the svf-server graphs and plugin commands\n");
+    if (Format != "csv" && Format != "json") {
+        errs() << "Error: unknown format: " << Format << "\n";
+        return 1;
+    }
+    ThreadPool::setNumThreads(Threads);
+
+    vector<string> fixtures(Inputs.begin(), Inputs.end());
+    if (fixtures.empty()) {
+        vector<unsigned int> sizes(Sizes.begin(), Sizes.end());
+        if (sizes.empty()) {
+            sizes = {100, 1000, 10000};
+        }
+        sys::fs::create_directories(FixtureDir);
+        for (unsigned int size : sizes) {
+            string path = FixtureDir + "/fixture-" + to_string(size) + ".ll";
+            if (!sys::fs::exists(path) && !writeFixture(path, max(2u, size))) {
+                return 1;
+            }
+            fixtures.push_back(path);
+        }
+    }
+
+    void *lib = dlopen(PluginPath.c_str(), RTLD_NOW);
+    if (lib == NULL) {
+        errs() << "Error: could not load " << PluginPath << ": " << dlerror() << "\n";
+        return 1;
+    }
+    void *maker = dlsym(lib, "getPlugin");
+    if (maker == NULL) {
+        errs() << "Error: Could not find getPlugin function for plugin\n";
+        return 1;
+    }
+    svf_analyzer func = reinterpret_cast<svf_analyzer>(reinterpret_cast<void*>(maker));
+    Plugin *plugin = func();
+    if (plugin == NULL) {
+        errs() << "Error: could not instantiate plugin object\n";
+        return 1;
+    }
+
+    int exitCode = 0;
+    vector<Row> rows;
+    for (auto &fixture : fixtures) {
+        if (!runFixture(fixture, plugin, rows)) {
+            exitCode = 1;
+        }
+    }
+
+    error_code ec;
+    unique_ptr<raw_fd_ostream> file;
+    if (!OutputFile.empty()) {
+        file.reset(new raw_fd_ostream(OutputFile, ec));
+        if (ec) {
+            errs() << "Error: could not open " << OutputFile << ": " << ec.message() << "\n";
+            return 1;
+        }
+    }
+    raw_ostream &os = file ? *file : outs();
+    if (Format == "csv") {
+        writeCSV(os, rows);
+    } else {
+        writeJSON(os, rows);
+    }
+    os.flush();
+
+    if (!Baseline.empty()) {
+        ifstream is(Baseline);
+        vector<Row> baseline;
+        if (!is.is_open() || !readCSV(is, baseline)) {
+            errs() << "Error: could not read baseline " << Baseline << "\n";
+            return 1;
+        }
+        if (!compareBaseline(rows, baseline)) {
+            exitCode = 1;
+        }
+    }
+
+    delete plugin;
+    dlclose(lib);
+    llvm::llvm_shutdown();
+    return exitCode;
+}
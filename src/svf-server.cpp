@@ -18,202 +18,228 @@
 #include "llvm/Support/Casting.h"
 #include "SVF-FE/LLVMUtil.h"
 #include "Util/SVFUtil.h"
-#include "Graphs/SVFG.h"
-#include "WPA/Andersen.h"
-#include "WPA/Steensgaard.h"
-#include "WPA/AndersenSFR.h"
-#include "WPA/FlowSensitive.h"
-#include "WPA/FlowSensitiveTBHC.h"
-#include "WPA/VersionedFlowSensitive.h"
-#include "SVF-FE/SVFIRBuilder.h"
-#include "Util/Options.h"
-#include <dlfcn.h>
 #include "svf-plugin.h"
 #include "ConsoleInput.h"
+#include "BatchInput.h"
+#include "Program.h"
+#include "ProgramRegistry.h"
+#include "Session.h"
+#include "SocketServer.h"
+#include "ResultCache.h"
+#include "ThreadPool.h"
+#include "SVFOptions.h"
+#include "WorkerPool.h"
 
 #include <list>
-#include <boost/algorithm/string/classification.hpp>
-#include <boost/algorithm/string/split.hpp>
-#include <boost/algorithm/string/join.hpp>
+#include <unistd.h>
 
 using namespace llvm;
 using namespace std;
 using namespace SVF;
 
+/// Options of the server which do not change analysis results. They are
+/// left out of the option hash, so e.g. a snapshot written with
+/// -snapshot-out is restored with -snapshot-in. The analysis kind is part
+/// of the identity on its own
+static llvm::cl::OptionCategory ServerOptions("svf-server options");
+
 static llvm::cl::opt<std::string> InputFilename(cl::Positional,
         llvm::cl::desc("<input bitcode>"), llvm::cl::init("-"));
 
-
-void usage() {
-    SVFUtil::outs() << "Available commands:\n";
-    SVFUtil::outs() << "    load <lib.so>  load library\n";
-    SVFUtil::outs() << "    ls             show available functions provided by loaded library\n";
-    SVFUtil::outs() << "    run <func>     run function from loaded library\n";
-    SVFUtil::outs() << "    help|?         show this help\n";
-    SVFUtil::outs() << "    exit           stop the server\n";
-}
+static llvm::cl::opt<unsigned int> Threads("threads",
+        llvm::cl::desc("Number of threads for parallel graph traversals (0 = one per core)"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned int> Workers("workers",
+        llvm::cl::desc("Run plugins in up to this many forked worker processes (0 = in the server)"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned int> WorkerTimeout("worker-timeout",
+        llvm::cl::desc("Stop runs in worker processes after this many seconds (0 = no limit)"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(0));
+
+static llvm::cl::opt<unsigned int> WorkerMemory("worker-memory",
+        llvm::cl::desc("Memory limit in MB of a worker process on top of the shared graphs (0 = no limit)"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(0));
+
+static llvm::cl::opt<std::string> PTAKind("pta",
+        llvm::cl::desc("Pointer analysis: andersen, steensgaard, hcd, lcd, hlcd, fs or fstbhc"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init("andersen"));
+
+static llvm::cl::opt<unsigned int> DemandBudget("dda-budget",
+        llvm::cl::desc("Default budget of demand-driven points-to queries (0 = SVF's -cxtbg)"),
+        llvm::cl::init(0));
+
+static llvm::cl::opt<bool> Prebuild("prebuild",
+        llvm::cl::desc("Build the graphs in the background while commands are served"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(false));
+
+static llvm::cl::opt<unsigned int> QueryCacheMemory("query-cache-memory",
+        llvm::cl::desc("Size limit in MB of the points-to sets kept for pts and alias queries"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(64));
+
+static llvm::cl::opt<bool> Lean("lean",
+        llvm::cl::desc("Keep points-to sets hash-consed and return the memory of finished builds to the system"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> BatchFile("batch",
+        llvm::cl::desc("Read commands from this file instead of the console and exit at its end"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(""));
+
+static llvm::cl::opt<bool> BatchStdin("stdin",
+        llvm::cl::desc("Read commands from stdin instead of the console and exit at its end"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(false));
+
+static llvm::cl::opt<std::string> SocketPath("socket",
+        llvm::cl::desc("Serve clients on this Unix domain socket instead of the console"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(""));
+
+static llvm::cl::opt<unsigned int> Port("port",
+        llvm::cl::desc("Serve clients on this TCP port on localhost instead of the console"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(0));
+
+static llvm::cl::opt<std::string> SnapshotIn("snapshot-in",
+        llvm::cl::desc("Restore points-to results and SVFG from snapshots in this directory"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> SnapshotOut("snapshot-out",
+        llvm::cl::desc("Write points-to results and SVFG to snapshots in this directory"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(""));
+
+static llvm::cl::opt<std::string> ResultCacheDir("result-cache",
+        llvm::cl::desc("Keep run results in this directory across restarts"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(""));
+
+static llvm::cl::opt<unsigned int> ResultCacheSize("result-cache-size",
+        llvm::cl::desc("Size limit in MB of the result cache directory"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(256));
+
+static llvm::cl::opt<unsigned int> ResultCacheMemory("result-cache-memory",
+        llvm::cl::desc("Size limit in MB of the run results kept in memory"),
+        llvm::cl::cat(ServerOptions),
+        llvm::cl::init(64));
 
 int main(int argc, char ** argv)
 {
-    SVFUtil::outs().SetUnbuffered();
-
+    // stdout is only unbuffered if it is a terminal, results written to a
+    // pipe or file are buffered and flushed after every command
     int arg_num = 0;
-    char **arg_value = new char*[argc];
+    char **arg_value = new char*[argc + 2];
     std::vector<std::string> moduleNameVec;
     SVFUtil::processArguments(argc, argv, arg_num, arg_value, moduleNameVec);
+
     cl::ParseCommandLineOptions(arg_num, arg_value,
                                 "Whole Program Points-to Analysis\n");
+    SVFOptions::setCommandLine(arg_num, arg_value, ServerOptions);
 
-    if (Options::WriteAnder == "ir_annotator")
-    {
-        LLVMModuleSet::getLLVMModuleSet()->preProcessBCs(moduleNameVec);
+    if (!Program::isPTAKind(PTAKind)) {
+        SVFUtil::outs() << "Error: unknown pointer analysis: " << PTAKind << "\n";
+        return 1;
+    }
+    // persistent points-to data stores every distinct set once, pointers
+    // with equal sets share it
+    if (Lean && !SVFOptions::isGiven("ptd") && !SVFOptions::set("ptd", "persistent")) {
+        SVFUtil::outs() << "Error: SVF has no persistent points-to data\n";
+        return 1;
     }
+    ThreadPool::setNumThreads(Threads);
+
+    /// Graphs are built on demand by the first run which needs them, or in
+    /// the background with -prebuild. The program of the command line is
+    /// the default of every session
+    ResultCache *resultCache = new ResultCache(ResultCacheMemory, ResultCacheDir, ResultCacheSize);
+    ProgramRegistry::Config config;
+    /// Snapshot of points-to results and SVFG, keyed by the input bitcode,
+    /// the analysis kind and the options, its SVF options are set when a
+    /// program is built
+    config.snapshotIn = SnapshotIn;
+    config.snapshotOut = SnapshotOut;
+    config.resultCache = resultCache;
+    config.ptaKind = PTAKind;
+    config.demandBudget = DemandBudget;
+    config.workers = Workers;
+    config.workerTimeout = WorkerTimeout;
+    config.workerMemory = WorkerMemory;
+    config.lean = Lean;
+    config.queryCacheMemory = QueryCacheMemory;
+    ProgramRegistry *registry = new ProgramRegistry(config);
+    if (!registry->open("default", moduleNameVec, SVFUtil::outs())) {
+        delete registry;
+        delete resultCache;
+        return 1;
+    }
+    if (Prebuild) {
+        registry->prebuild(registry->get("default"));
+    }
+    int exitCode = 0;
 
-    SVFUtil::outs() << "init svf module...\n";
-    SVFModule* svfModule = LLVMModuleSet::getLLVMModuleSet()->buildSVFModule(moduleNameVec);
-    svfModule->buildSymbolTableInfo();
-
-    /// Build Program Assignment Graph (SVFIR)
-    SVFIRBuilder builder;
-    SVFUtil::outs() << "build pag...\n";
-    SVFIR* pag = builder.build(svfModule);
-
-    /// Create Andersen's pointer analysis
-    SVFUtil::outs() << "running pointer analysis...\n";
-    PointerAnalysis* ander;
-    //ander = FlowSensitive::createFSWPA(pag);
-    //ander = Steensgaard::createSteensgaard(pag);
-    //ander = FlowSensitiveTBHC::createFSWPA(pag);
-    //ander = VersionedFlowSensitive::createVFSWPA(pag); // not supported
-    //ander = AndersenSFR::createAndersenSFR(pag); // crash
-    //ander = AndersenSCD::createAndersenSCD(pag); // crash
-    //ander = AndersenHLCD::createAndersenHLCD(pag);
-    //ander = AndersenHCD::createAndersenHCD(pag);
-    //ander = AndersenLCD::createAndersenLCD(pag);
-    ander = AndersenWaveDiff::createAndersenWaveDiff(pag);
-
-    /// Query aliases
-    /// aliasQuery(ander,value1,value2);
-
-    /// Print points-to information
-    /// printPts(ander, value1);
-
-    /// Call Graph
-    SVFUtil::outs() << "create call graph...\n";
-    PTACallGraph* callgraph = ander->getPTACallGraph();
-
-    /// ICFG
-    SVFUtil::outs() << "create ICFG...\n";
-    ICFG* icfg = pag->getICFG();
-
-    /// Value-Flow Graph (VFG)
-    SVFUtil::outs() << "create VFG...\n";
-    VFG* vfg = new VFG(callgraph);
-
-    /// Sparse value-flow graph (SVFG)
-    SVFGBuilder svfBuilder;
-    SVFUtil::outs() << "create svfg...\n";
-    //SVFG* svfg = svfBuilder.buildFullSVFGWithoutOPT((BVDataPTAImpl*)ander);
-    SVFG* svfg = svfBuilder.buildFullSVFG((BVDataPTAImpl*)ander);
-
-    // server loop
-    void *lib = NULL;
-    Plugin *plugin = NULL;
-    ConsoleInput cli;
-    string cmd;
-    string opt;
-    while (true) {
-        auto args = cli.readLine();
-        cmd = *args.cbegin();
-        args.pop_front();
-        if (args.size() > 0) {
-            opt = *args.cbegin();
-            args.pop_front();
+    if (!SocketPath.empty() || Port != 0) {
+        SocketServer server(registry);
+        if ((SocketPath.empty() || server.listenUnix(SocketPath)) &&
+            (Port == 0 || server.listenTCP(Port))) {
+            server.run();
+        } else {
+            exitCode = 1;
         }
-
-        if (cmd == "exit") {
-            SVFUtil::outs() << "Stopping server...\n";
-            break;
-        } else if (cmd == "load") {
-            // Load dym lib
-            if (opt.empty()) {
-                SVFUtil::outs() << "Error: please provide argument\n";
-                usage();
-                continue;
-            }
-            if (plugin != NULL) {
-                delete plugin;
-                plugin = NULL;
-            }
-            if (lib != NULL) {
-                dlclose(lib);
-                lib = NULL;
-            }
-            lib = dlopen(opt.c_str(), RTLD_NOW);
-            if (lib == NULL) {
-                SVFUtil::outs() << "Error: Coudl not load library\n";
-                continue;
-            }
-            void *maker = dlsym(lib, "getPlugin");
-            if (maker == NULL) {
-                SVFUtil::outs() << "Error: Could not find getPlugin function for plugin\n";
-                continue;
-            }
-            svf_analyzer func = reinterpret_cast<svf_analyzer>(reinterpret_cast<void*>(maker));
-            plugin = func();
-            if (plugin == NULL) {
-                SVFUtil::outs() << "Error: could not instantiate plugin object\n";
-                continue;
-            }
-            plugin->init(icfg, svfg);
-            SVFUtil::outs() << "library loaded\n";
-        } else if (cmd == "ls") {
-            // list help of plugin
-            if (plugin == NULL) {
-                SVFUtil::outs() << "Error: No library was loaded. Please load library first\n";
-                continue;
-            }
-            plugin->help();
-        } else if (cmd == "help") {
-            usage();
-        } else if (cmd == "?") {
-            usage();
-        } else if (cmd == "run") {
-            // run function from lib
-            if (opt.empty()) {
-                SVFUtil::outs() << "Error: please provide argument\n";
-                usage();
-                continue;
+    } else if (!BatchFile.empty() || BatchStdin) {
+        // batch mode, exit status reports failed commands
+        BatchInput input(BatchFile);
+        if (!input.isOpen()) {
+            SVFUtil::outs() << "Error: could not open " << BatchFile << "\n";
+            exitCode = 1;
+        } else {
+            Session session(registry);
+            while (true) {
+                Session::Status status = session.execute(input.readLine(), SVFUtil::outs());
+                SVFUtil::outs().flush();
+                if (status == Session::EXIT) {
+                    break;
+                } else if (status == Session::ERROR) {
+                    exitCode = 1;
+                }
             }
-            if (plugin == NULL) {
-                SVFUtil::outs() << "Error: No library was loaded. Please load library first\n";
-                continue;
+        }
+    } else {
+        // server loop
+        Session session(registry);
+        ConsoleInput cli;
+        while (true) {
+            auto args = cli.readLine();
+            Session::Status status = session.execute(args, SVFUtil::outs());
+            SVFUtil::outs().flush();
+            if (status == Session::EXIT) {
+                break;
             }
-            plugin->run(opt, args);
-        } else {
-            SVFUtil::outs() << "Error: Invalid command: " << cmd << " " << opt << " " << boost::algorithm::join(args, " ") << "\n";
-            usage();
         }
     }
-    if (plugin != NULL) {
-        delete plugin;
-        plugin = NULL;
-    }
-    if (lib != NULL) {
-        dlclose(lib);
-        lib = NULL;
+
+    // a graph build cannot be stopped, do not wait for it
+    if (registry->isBuilding()) {
+        SVFUtil::outs().flush();
+        _exit(exitCode);
     }
 
     // clean up memory
-    delete vfg;
-    delete svfg;
-    AndersenWaveDiff::releaseAndersenWaveDiff();
-    SVFIR::releaseSVFIR();
-
-    //LLVMModuleSet::getLLVMModuleSet()->dumpModulesToFile(".svf.bc");
-    SVF::LLVMModuleSet::releaseLLVMModuleSet();
+    delete registry;
+    delete resultCache;
 
     llvm::llvm_shutdown();
-    return 0;
+    return exitCode;
 }
 
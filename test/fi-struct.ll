@@ -0,0 +1,24 @@
+; Alias fixture for points-to-cache-test: the variant GEP on %s makes its
+; object field-insensitive, so its fields alias each other; %t stays
+; field-sensitive.
+
+%struct.S = type { i32*, i32* }
+
+define void @fields(i64 %n) {
+entry:
+  %s = alloca %struct.S
+  %s0 = getelementptr inbounds %struct.S, %struct.S* %s, i32 0, i32 0
+  %s1 = getelementptr inbounds %struct.S, %struct.S* %s, i32 0, i32 1
+  %sb = bitcast %struct.S* %s to i8*
+  %sv = getelementptr i8, i8* %sb, i64 %n
+  %t = alloca %struct.S
+  %t0 = getelementptr inbounds %struct.S, %struct.S* %t, i32 0, i32 0
+  %t1 = getelementptr inbounds %struct.S, %struct.S* %t, i32 0, i32 1
+  ret void
+}
+
+define i32 @main() {
+entry:
+  call void @fields(i64 8)
+  ret i32 0
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of the svf-server distribution (https://github.com/peckto/svf-server).
+ * Copyright (c) 2022 Tobias Specht.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// Compares the alias answers of PointsToCache with SVF's own alias query
+/// for all pairs of pointers of the given modules.
+/// usage: points-to-cache-test <file.ll|file.bc>...
+
+#include "PointsToCache.h"
+#include "SVF-FE/LLVMUtil.h"
+#include "SVF-FE/SVFIRBuilder.h"
+#include "WPA/Andersen.h"
+#include "llvm/IR/InstIterator.h"
+
+using namespace llvm;
+using namespace std;
+using namespace SVF;
+
+static void addPointer(const Value *value, SVFIR *pag, vector<NodeID> &pointers)
+{
+    if (value->getType()->isPointerTy() && pag->hasValueNode(value)) {
+        pointers.push_back(pag->getValueNode(value));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        SVFUtil::outs() << "usage: " << argv[0] << " <module>...\n";
+        return 1;
+    }
+    vector<string> moduleNameVec(argv + 1, argv + argc);
+    SVFModule *svfModule = LLVMModuleSet::getLLVMModuleSet()->buildSVFModule(moduleNameVec);
+    svfModule->buildSymbolTableInfo();
+    SVFIRBuilder builder;
+    SVFIR *pag = builder.build(svfModule);
+    AndersenWaveDiff *pta = AndersenWaveDiff::createAndersenWaveDiff(pag);
+
+    vector<NodeID> pointers;
+    for (const SVFFunction *fun : svfModule->getFunctionSet()) {
+        const Function *func = fun->getLLVMFun();
+        for (const Argument &arg : func->args()) {
+            addPointer(&arg, pag, pointers);
+        }
+        for (const Instruction &inst : instructions(func)) {
+            addPointer(&inst, pag, pointers);
+        }
+    }
+
+    PointsToCache cache(pag, pta, 64);
+    NodeID blackHole = pag->getBlackHoleNode();
+    unsigned int errors = 0;
+    // pairs only aliasing through the fields of a field-insensitive object
+    unsigned int expanded = 0;
+    for (size_t i = 0; i < pointers.size(); i++) {
+        for (size_t j = i + 1; j < pointers.size(); j++) {
+            NodeID a = pointers[i];
+            NodeID b = pointers[j];
+            bool svf = pta->alias(a, b) != SVF::AliasResult::NoAlias;
+            bool cached = cache.mayAlias(a, b);
+            if (svf != cached) {
+                SVFUtil::outs() << "Error: alias of nodes " << a << " and " << b << " is "
+                                << (cached ? "may" : "no") << ", SVF answers " << (svf ? "may" : "no") << "\n";
+                errors++;
+            }
+            const PointsTo &ptsA = pta->getPts(a);
+            const PointsTo &ptsB = pta->getPts(b);
+            if (svf && !FlatPointsTo(ptsA, ptsA, blackHole).intersects(FlatPointsTo(ptsB, ptsB, blackHole))) {
+                expanded++;
+            }
+        }
+    }
+    SVFUtil::outs() << pointers.size() << " pointers, " << expanded << " pairs alias through field-insensitive objects\n";
+    if (expanded == 0) {
+        SVFUtil::outs() << "Error: the modules have no field-insensitive object\n";
+        errors++;
+    }
+
+    AndersenWaveDiff::releaseAndersenWaveDiff();
+    SVFIR::releaseSVFIR();
+    LLVMModuleSet::releaseLLVMModuleSet();
+    return errors == 0 ? 0 : 1;
+}